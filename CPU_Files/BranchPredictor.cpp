@@ -0,0 +1,358 @@
+#include "BranchPredictor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+//2 bit saturating counter, taken when >= 2
+static void Train(uint8_t& ctr, bool taken)
+{
+    if (taken && ctr < 3)
+        ctr++;
+    else if (!taken && ctr > 0)
+        ctr--;
+}
+
+unique_ptr<BranchPredictor> BranchPredictor::Create(const string& spec)
+{
+    stringstream ss(spec);
+    string field;
+    vector<string> fields;
+    while (getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    if (fields.empty())
+        return nullptr;
+
+    vector<unsigned> args;
+    for (size_t f = 1; f < fields.size(); f++) {
+        unsigned v = (unsigned)strtoul(fields[f].c_str(), nullptr, 10);
+        if (v < 1 || v > 24)
+            return nullptr;
+        args.push_back(v);
+    }
+    if (fields[0] == "static" && args.empty())
+        return unique_ptr<BranchPredictor>(new StaticPredictor());
+    if (fields[0] == "bimodal" && args.size() <= 1)
+        return unique_ptr<BranchPredictor>(new BimodalPredictor(args.empty() ? 12 : args[0]));
+    if (fields[0] == "gshare" && args.size() <= 2) {
+        unsigned bits = args.empty() ? 12 : args[0];
+        unsigned hist = args.size() < 2 ? bits : min(args[1], 32u);
+        return unique_ptr<BranchPredictor>(new GsharePredictor(bits, hist));
+    }
+    if (fields[0] == "tage" && args.empty())
+        return unique_ptr<BranchPredictor>(new TagePredictor());
+    return nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////
+// BIMODAL / GSHARE
+//////////////////////////////////////////////////////////////////////
+
+BimodalPredictor::BimodalPredictor(unsigned bits)
+    : indexBits(bits), counters(1u << bits, 1)
+{
+}
+
+string BimodalPredictor::Name() const
+{
+    return "bimodal:" + to_string(indexBits);
+}
+
+bool BimodalPredictor::Predict(uint32_t pc, uint32_t)
+{
+    return counters[(pc >> 2) & ((1u << indexBits) - 1)] >= 2;
+}
+
+void BimodalPredictor::Update(uint32_t pc, uint32_t, bool taken)
+{
+    Train(counters[(pc >> 2) & ((1u << indexBits) - 1)], taken);
+}
+
+GsharePredictor::GsharePredictor(unsigned bits, unsigned hist)
+    : indexBits(bits), historyBits(hist), counters(1u << bits, 1)
+{
+}
+
+string GsharePredictor::Name() const
+{
+    return "gshare:" + to_string(indexBits) + ":" + to_string(historyBits);
+}
+
+unsigned GsharePredictor::Index(uint32_t pc) const
+{
+    return ((pc >> 2) ^ history) & ((1u << indexBits) - 1);
+}
+
+bool GsharePredictor::Predict(uint32_t pc, uint32_t)
+{
+    return counters[Index(pc)] >= 2;
+}
+
+void GsharePredictor::Update(uint32_t pc, uint32_t, bool taken)
+{
+    Train(counters[Index(pc)], taken);
+    uint32_t mask = historyBits >= 32 ? 0xFFFFFFFFu : (1u << historyBits) - 1;
+    history = ((history << 1) | (taken ? 1 : 0)) & mask;
+}
+
+//////////////////////////////////////////////////////////////////////
+// TAGE-LITE
+//////////////////////////////////////////////////////////////////////
+
+static const unsigned TAGE_HISTORY[] = { 4, 8, 16, 32 };
+
+//XOR the low `length` history bits down to `bits` bits
+static uint32_t Fold(uint64_t history, unsigned length, unsigned bits)
+{
+    uint64_t h = length >= 64 ? history : history & ((1ULL << length) - 1);
+    uint32_t folded = 0;
+    while (h) {
+        folded ^= (uint32_t)(h & ((1u << bits) - 1));
+        h >>= bits;
+    }
+    return folded;
+}
+
+TagePredictor::TagePredictor()
+    : base(1u << BASE_BITS, 1)
+{
+    for (int t = 0; t < NUM_TABLES; t++) {
+        tables[t].resize(1u << TABLE_BITS);
+    }
+}
+
+unsigned TagePredictor::Index(uint32_t pc, int table) const
+{
+    uint32_t p = pc >> 2;
+    return (p ^ (p >> TABLE_BITS) ^ Fold(history, TAGE_HISTORY[table], TABLE_BITS)) & ((1u << TABLE_BITS) - 1);
+}
+
+uint16_t TagePredictor::Tag(uint32_t pc, int table) const
+{
+    uint32_t p = pc >> 2;
+    return (uint16_t)((p ^ Fold(history, TAGE_HISTORY[table], 8) ^ (Fold(history, TAGE_HISTORY[table], 7) << 1)) & 0xFF);
+}
+
+bool TagePredictor::BasePredict(uint32_t pc) const
+{
+    return base[(pc >> 2) & ((1u << BASE_BITS) - 1)] >= 2;
+}
+
+bool TagePredictor::Predict(uint32_t pc, uint32_t)
+{
+    provider = alternate = -1;
+    for (int t = 0; t < NUM_TABLES; t++) {
+        indices[t] = Index(pc, t);
+        tags[t] = Tag(pc, t);
+    }
+    for (int t = NUM_TABLES - 1; t >= 0; t--) {
+        const Entry& e = tables[t][indices[t]];
+        if (e.valid && e.tag == tags[t]) {
+            if (provider < 0)
+                provider = t;
+            else if (alternate < 0)
+                alternate = t;
+        }
+    }
+    altPred = alternate >= 0 ? tables[alternate][indices[alternate]].ctr >= 0 : BasePredict(pc);
+    providerPred = provider >= 0 ? tables[provider][indices[provider]].ctr >= 0 : altPred;
+    return providerPred;
+}
+
+void TagePredictor::Update(uint32_t pc, uint32_t, bool taken)
+{
+    if (provider >= 0) {
+        Entry& e = tables[provider][indices[provider]];
+        if (taken && e.ctr < 3)
+            e.ctr++;
+        else if (!taken && e.ctr > -4)
+            e.ctr--;
+        if (providerPred != altPred) {
+            if (providerPred == taken && e.useful < 3)
+                e.useful++;
+            else if (providerPred != taken && e.useful > 0)
+                e.useful--;
+        }
+    }
+    else {
+        Train(base[(pc >> 2) & ((1u << BASE_BITS) - 1)], taken);
+    }
+
+    //Mispredicted: take over a non-useful entry in a longer history table
+    if (providerPred != taken && provider < NUM_TABLES - 1) {
+        bool allocated = false;
+        for (int t = provider + 1; t < NUM_TABLES && !allocated; t++) {
+            Entry& e = tables[t][indices[t]];
+            if (!e.valid || e.useful == 0) {
+                e.valid = true;
+                e.tag = tags[t];
+                e.ctr = taken ? 0 : -1;
+                e.useful = 0;
+                allocated = true;
+            }
+        }
+        if (!allocated) {
+            for (int t = provider + 1; t < NUM_TABLES; t++) {
+                Entry& e = tables[t][indices[t]];
+                if (e.useful > 0)
+                    e.useful--;
+            }
+        }
+    }
+
+    //Age useful bits so stale entries can be replaced
+    if ((++branches & 0x3FFFF) == 0) {
+        for (int t = 0; t < NUM_TABLES; t++) {
+            for (Entry& e : tables[t]) {
+                e.useful >>= 1;
+            }
+        }
+    }
+    history = (history << 1) | (taken ? 1 : 0);
+}
+
+//////////////////////////////////////////////////////////////////////
+// BTB / RAS
+//////////////////////////////////////////////////////////////////////
+
+BranchTargetBuffer::BranchTargetBuffer(unsigned n)
+    : entries(n ? n : 1)
+{
+}
+
+bool BranchTargetBuffer::Lookup(uint32_t pc, uint32_t target)
+{
+    const Entry& e = entries[(pc >> 2) % entries.size()];
+    lookups++;
+    if (!(e.valid && e.pc == pc))
+        return false;
+    if (e.target != target) {
+        wrongTarget++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+void BranchTargetBuffer::Insert(uint32_t pc, uint32_t target)
+{
+    Entry& e = entries[(pc >> 2) % entries.size()];
+    e.valid = true;
+    e.pc = pc;
+    e.target = target;
+}
+
+ReturnAddressStack::ReturnAddressStack(unsigned depth)
+    : stack(depth ? depth : 1)
+{
+}
+
+void ReturnAddressStack::Push(uint32_t returnAddress)
+{
+    pushes++;
+    if (size == stack.size())
+        overflows++; //oldest entry is overwritten
+    else
+        size++;
+    stack[top] = returnAddress;
+    top = (top + 1) % stack.size();
+    maxDepth = max(maxDepth, size);
+}
+
+bool ReturnAddressStack::Pop(uint32_t& returnAddress)
+{
+    if (size == 0)
+        return false;
+    top = (top + stack.size() - 1) % stack.size();
+    size--;
+    returnAddress = stack[top];
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// BRANCH MODEL
+//////////////////////////////////////////////////////////////////////
+
+BranchModel::BranchModel(unsigned btbEntries, unsigned rasDepth)
+    : btb(btbEntries), ras(rasDepth)
+{
+}
+
+void BranchModel::AddPredictor(unique_ptr<BranchPredictor> predictor)
+{
+    Model m;
+    m.predictor = move(predictor);
+    predictors.push_back(move(m));
+}
+
+void BranchModel::Conditional(uint32_t pc, uint32_t target, bool taken)
+{
+    for (Model& m : predictors) {
+        bool predicted = m.predictor->Predict(pc, target);
+        m.predictor->Update(pc, target, taken);
+        Stats& perPC = m.byPC[pc];
+        m.total.branches++;
+        perPC.branches++;
+        if (predicted != taken) {
+            m.total.mispredicts++;
+            perPC.mispredicts++;
+        }
+    }
+    //Only taken branches need a target from the BTB
+    if (taken && !btb.Lookup(pc, target))
+        btb.Insert(pc, target);
+}
+
+void BranchModel::Jump(uint32_t pc, uint32_t target, bool link)
+{
+    if (!btb.Lookup(pc, target))
+        btb.Insert(pc, target);
+    if (link)
+        ras.Push(pc + 4);
+}
+
+void BranchModel::ResetStats()
+{
+    for (Model& m : predictors) {
+        m.total = Stats();
+        m.byPC.clear();
+    }
+    btb.lookups = btb.hits = btb.wrongTarget = 0;
+    ras.pushes = ras.overflows = 0;
+    ras.maxDepth = 0;
+}
+
+void BranchModel::Report(ostream& out, unsigned long long instret, size_t topPCs) const
+{
+    double kilo = instret / 1000.0;
+    out << fixed << setprecision(2);
+    for (const Model& m : predictors) {
+        const Stats& s = m.total;
+        out << "[BPRED] " << m.predictor->Name() << ": " << s.branches << " branches, " << s.mispredicts << " mispredicted, "
+            << (s.branches ? 100.0 * (s.branches - s.mispredicts) / s.branches : 0.0) << " % accuracy, "
+            << (kilo > 0 ? s.mispredicts / kilo : 0.0) << " MPKI" << endl;
+
+        vector<pair<unsigned long long, uint32_t>> order;
+        for (const pair<const uint32_t, Stats>& p : m.byPC) {
+            if (p.second.mispredicts)
+                order.push_back(make_pair(p.second.mispredicts, p.first));
+        }
+        sort(order.begin(), order.end(), [](const pair<unsigned long long, uint32_t>& a, const pair<unsigned long long, uint32_t>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        if (order.size() > topPCs)
+            order.resize(topPCs);
+        for (const pair<unsigned long long, uint32_t>& o : order) {
+            const Stats& p = m.byPC.at(o.second);
+            out << "  pc 0x" << hex << o.second << dec << ": " << p.mispredicts << "/" << p.branches << " mispredicted, "
+                << 100.0 * (p.branches - p.mispredicts) / p.branches << " % accuracy, "
+                << (kilo > 0 ? p.mispredicts / kilo : 0.0) << " MPKI" << endl;
+        }
+    }
+    out << "[BTB] " << btb.lookups << " lookups, " << btb.hits << " hits, " << btb.wrongTarget << " wrong target" << endl;
+    out << "[RAS] " << ras.pushes << " pushes, max depth " << ras.maxDepth << ", " << ras.overflows << " overflows" << endl;
+    out.unsetf(ios::floatfield);
+    out << setprecision(6);
+}
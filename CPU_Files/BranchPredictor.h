@@ -0,0 +1,172 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// BRANCH PREDICTION MODELS
+//
+// Direction predictors see every BEQ (a conditional Controller::Branch),
+// each predicting before the outcome is known and training right after.
+// JAL is always taken, so it only goes through the BTB and, when it
+// writes a link register, pushes the return address stack. The models
+// run beside the datapath and never change what the guest computes.
+// Any number of predictors can be attached to one run and see the same
+// branch stream.
+//////////////////////////////////////////////////////////////////////
+
+class BranchPredictor {
+public:
+	virtual ~BranchPredictor() {}
+	virtual string Name() const = 0;
+	//target is the decoded branch target (PC + immediate)
+	virtual bool Predict(uint32_t pc, uint32_t target) = 0;
+	virtual void Update(uint32_t pc, uint32_t target, bool taken) = 0;
+
+	//"static", "bimodal[:bits]", "gshare[:bits[:history]]" or "tage".
+	//Returns nullptr for an unknown spec.
+	static unique_ptr<BranchPredictor> Create(const string& spec);
+};
+
+//Backward taken, forward not taken
+class StaticPredictor : public BranchPredictor {
+public:
+	string Name() const override { return "static"; }
+	bool Predict(uint32_t pc, uint32_t target) override { return target <= pc; }
+	void Update(uint32_t, uint32_t, bool) override {}
+};
+
+//Table of 2 bit saturating counters indexed by PC
+class BimodalPredictor : public BranchPredictor {
+public:
+	explicit BimodalPredictor(unsigned indexBits = 12);
+	string Name() const override;
+	bool Predict(uint32_t pc, uint32_t target) override;
+	void Update(uint32_t pc, uint32_t target, bool taken) override;
+
+private:
+	unsigned indexBits;
+	vector<uint8_t> counters;
+};
+
+//2 bit counters indexed by PC xor global history
+class GsharePredictor : public BranchPredictor {
+public:
+	GsharePredictor(unsigned indexBits = 12, unsigned historyBits = 12);
+	string Name() const override;
+	bool Predict(uint32_t pc, uint32_t target) override;
+	void Update(uint32_t pc, uint32_t target, bool taken) override;
+
+private:
+	unsigned indexBits, historyBits;
+	uint32_t history = 0;
+	vector<uint8_t> counters;
+	unsigned Index(uint32_t pc) const;
+};
+
+//Small TAGE: a bimodal base plus four tagged tables with geometric
+//history lengths (4, 8, 16, 32). The longest matching table provides the
+//prediction; a misprediction allocates an entry in a longer table.
+class TagePredictor : public BranchPredictor {
+public:
+	TagePredictor();
+	string Name() const override { return "tage"; }
+	bool Predict(uint32_t pc, uint32_t target) override;
+	void Update(uint32_t pc, uint32_t target, bool taken) override;
+
+private:
+	static const int NUM_TABLES = 4;
+	static const unsigned TABLE_BITS = 10;
+	static const unsigned BASE_BITS = 12;
+	struct Entry {
+		int8_t ctr = 0;   //3 bit signed counter, taken when >= 0
+		uint16_t tag = 0;
+		uint8_t useful = 0;
+		bool valid = false;
+	};
+	vector<Entry> tables[NUM_TABLES];
+	vector<uint8_t> base;
+	uint64_t history = 0;
+	unsigned long long branches = 0;
+
+	//Lookup results carried from Predict to Update
+	unsigned indices[NUM_TABLES];
+	uint16_t tags[NUM_TABLES];
+	int provider = -1, alternate = -1;
+	bool providerPred = false, altPred = false;
+
+	unsigned Index(uint32_t pc, int table) const;
+	uint16_t Tag(uint32_t pc, int table) const;
+	bool BasePredict(uint32_t pc) const;
+};
+
+//Direct mapped branch target buffer
+class BranchTargetBuffer {
+public:
+	explicit BranchTargetBuffer(unsigned entries = 512);
+	//True when the BTB holds pc and predicts target
+	bool Lookup(uint32_t pc, uint32_t target);
+	void Insert(uint32_t pc, uint32_t target);
+
+	unsigned long long lookups = 0, hits = 0, wrongTarget = 0;
+
+private:
+	struct Entry {
+		bool valid = false;
+		uint32_t pc = 0;
+		uint32_t target = 0;
+	};
+	vector<Entry> entries;
+};
+
+//Circular return address stack
+class ReturnAddressStack {
+public:
+	explicit ReturnAddressStack(unsigned depth = 16);
+	void Push(uint32_t returnAddress);
+	//Predicted return target. The RV32 subset here has no JALR, so the run loop never pops.
+	bool Pop(uint32_t& returnAddress);
+
+	unsigned long long pushes = 0, overflows = 0;
+	unsigned maxDepth = 0;
+
+private:
+	vector<uint32_t> stack;
+	unsigned top = 0, size = 0;
+};
+
+class BranchModel {
+public:
+	BranchModel(unsigned btbEntries = 512, unsigned rasDepth = 16);
+	void AddPredictor(unique_ptr<BranchPredictor> predictor);
+	bool Empty() const { return predictors.empty(); }
+
+	//Conditional branch (BEQ) with its decoded target and actual outcome
+	void Conditional(uint32_t pc, uint32_t target, bool taken);
+	//JAL; link is true when it writes a return address (rd != x0)
+	void Jump(uint32_t pc, uint32_t target, bool link);
+
+	unsigned long long Mispredicts(size_t predictor) const { return predictors[predictor].total.mispredicts; }
+	//Clears the counters but keeps predictor, BTB and RAS contents (end of a warm-up)
+	void ResetStats();
+
+	//Accuracy and MPKI per predictor and for the topPCs worst branch PCs
+	void Report(ostream& out, unsigned long long instret, size_t topPCs = 10) const;
+
+private:
+	struct Stats {
+		unsigned long long branches = 0, mispredicts = 0;
+	};
+	struct Model {
+		unique_ptr<BranchPredictor> predictor;
+		Stats total;
+		map<uint32_t, Stats> byPC;
+	};
+	vector<Model> predictors;
+	BranchTargetBuffer btb;
+	ReturnAddressStack ras;
+};
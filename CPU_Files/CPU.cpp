@@ -1,4 +1,5 @@
 #include "CPU.h"
+#include "Devices.h"
 
 //////////////////////////////////////////////////////////////////////
 //CONSTRUCTORS
@@ -11,12 +12,58 @@ CPU::CPU()
 	{
 		dmemory[i] = (0);
 	}
+	for (uint64_t& bits : dirtyLines)
+	{
+		bits = 0;
+	}
+}
+
+void CPU::Reset()
+{
+	PC = 0;
+	writeEpoch = 0;
+	for (int w = 0; w < 4096 / LINE_WORDS / 64; w++)
+	{
+		//Walk the set bits only, so the cost follows the number of lines touched
+		while (dirtyLines[w] != 0)
+		{
+			int line = w * 64 + __builtin_ctzll(dirtyLines[w]);
+			for (int i = line * LINE_WORDS; i < (line + 1) * LINE_WORDS; i++)
+			{
+				dmemory[i] = 0;
+			}
+			dirtyLines[w] &= dirtyLines[w] - 1;
+		}
+	}
+}
+
+void CPU::SaveMemory(int out[]) const
+{
+	for (int i = 0; i < 4096; i++)
+	{
+		out[i] = dmemory[i];
+	}
+}
+
+void CPU::RestoreMemory(const int in[])
+{
+	for (int i = 0; i < 4096; i++)
+	{
+		dmemory[i] = in[i];
+		if (in[i] != 0)
+			MarkDirty(i);
+	}
 }
 
 //Insturction Fetch (Done upon initialization of Instruction object)
 Instruction::Instruction(unsigned char instructionMem[], CPU cpu)
+    : Instruction(instructionMem, cpu.readPC())
+{
+}
+
+//Fetch straight from a PC value so harts do not need their own CPU object
+Instruction::Instruction(unsigned char instructionMem[], unsigned long currentPC)
 {
-    unsigned long currentPC = cpu.readPC();
     //Load the First 
     // Combine the 8 ASCII hex characters into a 32-bit integer
     uint32_t combined = 0;
@@ -223,13 +270,23 @@ void CPU::incPC(unsigned long nextPC)
 
 int32_t CPU::DataMemory(int MemWrite, int MemRead, int ALUResult, int rs2, bool word)
 {
+    //Past the end of RAM: device bus. This is the only check on the RAM path.
+    if ((unsigned)ALUResult >= (unsigned)RAM_BYTES)
+        return (MemWrite || MemRead) ? DeviceAccess(MemWrite, MemRead, ALUResult, rs2, word) : -1;
+
     if (MemWrite && word) {
+        if (dmemory[ALUResult / 4] != rs2)
+            writeEpoch++;
         dmemory[ALUResult / 4] = rs2;
+        MarkDirty(ALUResult / 4);
         return 0;
     }
     //IF the store is just a byte
     else if (MemWrite && !(word) ) {
+        if (dmemory[ALUResult / 4] != (rs2 & 0xFF))
+            writeEpoch++;
         dmemory[ALUResult / 4] = rs2 & 0xFF;
+        MarkDirty(ALUResult / 4);
         return 0;
     }
     else if (MemRead && word) {
@@ -242,6 +299,20 @@ int32_t CPU::DataMemory(int MemWrite, int MemRead, int ALUResult, int rs2, bool
     else
         return -1;
 }
+//Device state can change on any access (a FIFO pops on read), so it also moves the write epoch.
+//Without a bus the access reads 0 and changes nothing.
+int32_t CPU::DeviceAccess(int MemWrite, int MemRead, int ALUResult, int rs2, bool word)
+{
+    if (bus == nullptr)
+        return 0;
+    writeEpoch++;
+    int32_t value = 0;
+    if (MemWrite)
+        bus->Write((uint32_t)ALUResult, rs2, word);
+    else if (MemRead)
+        bus->Read((uint32_t)ALUResult, word, value);
+    return MemWrite ? 0 : value;
+}
 //////////////////////////////////////////////////////////////////////
 
 
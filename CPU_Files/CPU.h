@@ -7,16 +7,33 @@
 using namespace std;
 
 
+class MMIOBus;
+
 class CPU {
 private:
 	int dmemory[4096]; //data memory byte addressable in little endian fashion;
 	unsigned long PC; //pc 
 
+	//One bit per 16-word (64 byte) line of dmemory written since the last Reset()
+	static const int LINE_WORDS = 16;
+	uint64_t dirtyLines[4096 / LINE_WORDS / 64];
+	void MarkDirty(int index) { if (index >= 0 && index < 4096) dirtyLines[index / (LINE_WORDS * 64)] |= 1ULL << ((index / LINE_WORDS) % 64); }
+
+	MMIOBus* bus = nullptr; //devices past the end of RAM (see Devices.h)
+	int32_t DeviceAccess(int MemWrite, int MemRead, int ALUResult, int rs2, bool word);
+
 public:
+	static const int RAM_BYTES = 4096 * 4;
+	unsigned long long writeEpoch = 0; //bumped by every store that changes a word (and every access to a mapped bus)
+
 	CPU();
+	void Reset(); //same state as a fresh CPU, but only clears the lines that were written
+	void SaveMemory(int out[]) const; //copies all 4096 data words (checkpoints)
+	void RestoreMemory(const int in[]);
 	unsigned long readPC();
 	void incPC(unsigned long nextPC);
 	int32_t DataMemory(int MemWrite, int MemRead, int ALUResult, int rs2, bool word);
+	void AttachBus(MMIOBus* devices) { bus = devices; }
 
 };
 
@@ -24,6 +41,7 @@ class Instruction { // optional
 public:
 	bitset<32> instr = 0;//instruction
 	Instruction(unsigned char instructionMem[], CPU cpu); // constructor
+	Instruction(unsigned char instructionMem[], unsigned long pc); // fetch without a CPU (used by harts)
 };
 
 
@@ -0,0 +1,288 @@
+#include "CacheSim.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+static bool IsPowerOfTwo(unsigned v)
+{
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+static unsigned Log2(unsigned v)
+{
+    unsigned s = 0;
+    while ((1u << s) < v) {
+        s++;
+    }
+    return s;
+}
+
+static const char* PolicyName(ReplacementPolicy policy)
+{
+    switch (policy) {
+    case POLICY_PLRU: return "plru";
+    case POLICY_RANDOM: return "random";
+    default: return "lru";
+    }
+}
+
+bool CacheConfig::Parse(const string& spec, CacheConfig& config)
+{
+    stringstream ss(spec);
+    string field;
+    vector<string> fields;
+    while (getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 3 || fields.size() > 4)
+        return false;
+
+    CacheConfig c;
+    c.sizeBytes = (unsigned)strtoul(fields[0].c_str(), nullptr, 0);
+    c.assoc = (unsigned)strtoul(fields[1].c_str(), nullptr, 0);
+    c.lineBytes = (unsigned)strtoul(fields[2].c_str(), nullptr, 0);
+    if (fields.size() == 4) {
+        if (fields[3] == "lru")
+            c.policy = POLICY_LRU;
+        else if (fields[3] == "plru")
+            c.policy = POLICY_PLRU;
+        else if (fields[3] == "random")
+            c.policy = POLICY_RANDOM;
+        else
+            return false;
+    }
+    if (!IsPowerOfTwo(c.sizeBytes) || !IsPowerOfTwo(c.assoc) || !IsPowerOfTwo(c.lineBytes))
+        return false;
+    if (c.lineBytes < 4 || c.assoc * c.lineBytes > c.sizeBytes)
+        return false;
+    if (c.policy == POLICY_PLRU && c.assoc > 32)
+        return false; //tree bits live in one 32 bit word per set
+
+    c.name = spec;
+    config = c;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// CACHE
+//////////////////////////////////////////////////////////////////////
+
+Cache::Cache(const CacheConfig& c)
+    : config(c)
+{
+    numSets = c.sizeBytes / (c.assoc * c.lineBytes);
+    lineShift = Log2(c.lineBytes);
+    setShift = Log2(numSets);
+    tags.assign(numSets * c.assoc, 0);
+    valid.assign(numSets * c.assoc, false);
+    lastUse.assign(numSets * c.assoc, 0);
+    plruBits.assign(numSets, 0);
+}
+
+bool Cache::Access(uint32_t addr)
+{
+    uint32_t line = addr >> lineShift;
+    unsigned set = line & (numSets - 1);
+    uint32_t tag = line >> setShift;
+    unsigned base = set * config.assoc;
+    clock++;
+
+    for (unsigned way = 0; way < config.assoc; way++) {
+        if (valid[base + way] && tags[base + way] == tag) {
+            Touch(set, way);
+            return true;
+        }
+    }
+
+    unsigned way = Victim(set);
+    tags[base + way] = tag;
+    valid[base + way] = true;
+    Touch(set, way);
+    return false;
+}
+
+unsigned Cache::Victim(unsigned set)
+{
+    unsigned base = set * config.assoc;
+    //Empty ways fill first under every policy
+    for (unsigned way = 0; way < config.assoc; way++) {
+        if (!valid[base + way])
+            return way;
+    }
+
+    if (config.policy == POLICY_RANDOM) {
+        //xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng & (config.assoc - 1);
+    }
+    if (config.policy == POLICY_PLRU) {
+        //Follow the tree bits away from the recently used half
+        unsigned node = 1;
+        while (node < config.assoc) {
+            node = node * 2 + ((plruBits[set] >> node) & 1);
+        }
+        return node - config.assoc;
+    }
+
+    unsigned victim = 0;
+    for (unsigned way = 1; way < config.assoc; way++) {
+        if (lastUse[base + way] < lastUse[base + victim])
+            victim = way;
+    }
+    return victim;
+}
+
+void Cache::Touch(unsigned set, unsigned way)
+{
+    lastUse[set * config.assoc + way] = clock;
+
+    //Tree PLRU: nodes 1..assoc-1, bit = 1 means "the victim is in the right subtree".
+    //Point every node on the path at the other half from the one just used.
+    unsigned node = way + config.assoc;
+    while (node > 1) {
+        unsigned parent = node / 2;
+        if (node & 1)
+            plruBits[set] &= ~(1u << parent);
+        else
+            plruBits[set] |= (1u << parent);
+        node = parent;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// CACHE SIMULATOR
+//////////////////////////////////////////////////////////////////////
+
+void CacheSim::AddConfig(const CacheConfig& config)
+{
+    levels.emplace_back(config);
+}
+
+void CacheSim::Access(AccessType type, uint32_t pc, uint32_t addr)
+{
+    for (Level& level : levels) {
+        Cache& cache = type == ACCESS_FETCH ? level.icache : level.dcache;
+        bool hit = cache.Access(addr);
+        CacheStats& total = level.byType[type];
+        CacheStats& perPC = level.byPC[pc].byType[type];
+        if (hit) {
+            total.hits++;
+            perPC.hits++;
+        }
+        else {
+            total.misses++;
+            perPC.misses++;
+        }
+    }
+}
+
+unsigned long long CacheSim::Misses(size_t config) const
+{
+    unsigned long long misses = 0;
+    for (int t = 0; t < NUM_ACCESS_TYPES; t++) {
+        misses += levels[config].byType[t].misses;
+    }
+    return misses;
+}
+
+void CacheSim::ResetStats()
+{
+    for (Level& level : levels) {
+        for (int t = 0; t < NUM_ACCESS_TYPES; t++) {
+            level.byType[t] = CacheStats();
+        }
+        level.byPC.clear();
+    }
+}
+
+static double MissRate(const CacheStats& s)
+{
+    unsigned long long n = s.hits + s.misses;
+    return n ? 100.0 * s.misses / n : 0.0;
+}
+
+void CacheSim::Report(ostream& out, size_t topPCs) const
+{
+    static const char* typeNames[NUM_ACCESS_TYPES] = { "fetch", "load", "store" };
+
+    out << fixed << setprecision(2);
+    for (const Level& level : levels) {
+        const CacheConfig& c = level.config;
+        out << "[CACHE] " << c.name << " (" << c.sizeBytes << " B, " << c.assoc << "-way, "
+            << c.lineBytes << " B lines, " << PolicyName(c.policy) << ")" << endl;
+        for (int t = 0; t < NUM_ACCESS_TYPES; t++) {
+            const CacheStats& s = level.byType[t];
+            out << "  " << setw(5) << typeNames[t] << ": " << s.hits + s.misses << " accesses, "
+                << s.misses << " misses, " << MissRate(s) << " % miss rate" << endl;
+        }
+
+        //Worst PCs by total misses
+        vector<pair<unsigned long long, uint32_t>> order;
+        for (const pair<const uint32_t, PCStats>& p : level.byPC) {
+            unsigned long long misses = 0;
+            for (int t = 0; t < NUM_ACCESS_TYPES; t++) {
+                misses += p.second.byType[t].misses;
+            }
+            if (misses)
+                order.push_back(make_pair(misses, p.first));
+        }
+        sort(order.begin(), order.end(), [](const pair<unsigned long long, uint32_t>& a, const pair<unsigned long long, uint32_t>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        if (order.size() > topPCs)
+            order.resize(topPCs);
+        for (const pair<unsigned long long, uint32_t>& o : order) {
+            const PCStats& s = level.byPC.at(o.second);
+            out << "  pc 0x" << hex << o.second << dec << ":";
+            for (int t = 0; t < NUM_ACCESS_TYPES; t++) {
+                if (s.byType[t].hits + s.byType[t].misses)
+                    out << " " << typeNames[t] << " " << s.byType[t].misses << "/" << s.byType[t].hits + s.byType[t].misses
+                        << " (" << MissRate(s.byType[t]) << " %)";
+            }
+            out << endl;
+        }
+    }
+    out.unsetf(ios::floatfield);
+    out << setprecision(6);
+}
+
+//////////////////////////////////////////////////////////////////////
+// TRACES
+//////////////////////////////////////////////////////////////////////
+
+void WriteTraceRecord(ostream& out, AccessType type, uint32_t pc, uint32_t addr)
+{
+    static const char typeChars[NUM_ACCESS_TYPES] = { 'F', 'L', 'S' };
+    out << typeChars[type] << ' ' << hex << pc << ' ' << addr << dec << '\n';
+}
+
+long long ReplayTrace(istream& in, CacheSim& sim)
+{
+    string line;
+    long long records = 0;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        stringstream ss(line);
+        char kind;
+        uint32_t pc, addr;
+        if (!(ss >> kind >> hex >> pc >> addr))
+            return -1;
+        AccessType type;
+        if (kind == 'F')
+            type = ACCESS_FETCH;
+        else if (kind == 'L')
+            type = ACCESS_LOAD;
+        else if (kind == 'S')
+            type = ACCESS_STORE;
+        else
+            return -1;
+        sim.Access(type, pc, addr);
+        records++;
+    }
+    return records;
+}
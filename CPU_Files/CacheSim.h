@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// TRACE DRIVEN L1 CACHE MODEL
+//
+// Every instruction fetch and every load/store is fed to a set of cache
+// configurations at once, so one guest run (or one pass over a recorded
+// trace) compares them all. Each configuration is a split L1: an
+// instruction cache for fetches and a data cache for loads and stores,
+// both using the same geometry and replacement policy. The model only
+// keeps tags. It never holds data and does not change what the guest
+// computes.
+//
+// Trace format (one access per line, hex): <F|L|S> <pc> <address>
+//////////////////////////////////////////////////////////////////////
+
+enum AccessType { ACCESS_FETCH, ACCESS_LOAD, ACCESS_STORE, NUM_ACCESS_TYPES };
+enum ReplacementPolicy { POLICY_LRU, POLICY_PLRU, POLICY_RANDOM };
+
+struct CacheConfig {
+	string name;
+	unsigned sizeBytes = 4096;
+	unsigned assoc = 2;
+	unsigned lineBytes = 32;
+	ReplacementPolicy policy = POLICY_LRU;
+
+	//"size:assoc:line:policy", e.g. "4096:2:32:lru" (policy is lru, plru or random).
+	//Sizes must be powers of two. Returns false on a malformed spec.
+	static bool Parse(const string& spec, CacheConfig& config);
+};
+
+struct CacheStats {
+	unsigned long long hits = 0;
+	unsigned long long misses = 0;
+};
+
+//One set associative cache (tags only)
+class Cache {
+public:
+	explicit Cache(const CacheConfig& config);
+
+	//Looks up addr and fills the line on a miss. Returns true on a hit.
+	bool Access(uint32_t addr);
+
+private:
+	CacheConfig config;
+	unsigned numSets;
+	unsigned lineShift;
+	unsigned setShift;
+	vector<uint32_t> tags;           //numSets * assoc
+	vector<bool> valid;
+	vector<unsigned long long> lastUse; //LRU timestamps
+	vector<uint32_t> plruBits;       //one tree of assoc-1 bits per set
+	unsigned long long clock = 0;
+	uint32_t rng = 0x2545F491;       //fixed seed keeps random replacement reproducible
+
+	unsigned Victim(unsigned set);
+	void Touch(unsigned set, unsigned way);
+};
+
+class CacheSim {
+public:
+	void AddConfig(const CacheConfig& config);
+	bool Empty() const { return levels.empty(); }
+
+	void Access(AccessType type, uint32_t pc, uint32_t addr);
+
+	//Misses of configuration `config`, all access types
+	unsigned long long Misses(size_t config) const;
+	//Clears the counters but keeps the cache contents (end of a warm-up)
+	void ResetStats();
+
+	//Per configuration: hit/miss rate per access type and the topPCs PCs with the most misses
+	void Report(ostream& out, size_t topPCs = 10) const;
+
+private:
+	struct PCStats {
+		CacheStats byType[NUM_ACCESS_TYPES];
+	};
+	struct Level {
+		CacheConfig config;
+		Cache icache;
+		Cache dcache;
+		CacheStats byType[NUM_ACCESS_TYPES];
+		unordered_map<uint32_t, PCStats> byPC;
+		explicit Level(const CacheConfig& c) : config(c), icache(c), dcache(c) {}
+	};
+	vector<Level> levels;
+};
+
+void WriteTraceRecord(ostream& out, AccessType type, uint32_t pc, uint32_t addr);
+
+//Feeds every record of a trace to sim. Returns the number of records, or -1 on a malformed line.
+long long ReplayTrace(istream& in, CacheSim& sim);
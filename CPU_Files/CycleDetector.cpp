@@ -0,0 +1,54 @@
+#include "CycleDetector.h"
+
+uint64_t CycleDetector::Fingerprint(unsigned long pc, const int registers[], unsigned long long writeEpoch)
+{
+    //FNV-1a over PC, x1..x31 and the epoch (x0 is always 0)
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](uint64_t v) {
+        h ^= v;
+        h *= 1099511628211ULL;
+    };
+    mix(pc);
+    for (int i = 1; i < 32; i++) {
+        mix(static_cast<uint32_t>(registers[i]));
+    }
+    mix(writeEpoch);
+    return h;
+}
+
+bool CycleDetector::Observe(unsigned long pc, const int registers[], unsigned long long writeEpoch, unsigned long long instret)
+{
+    uint64_t h = Fingerprint(pc, registers, writeEpoch);
+
+    if (haveTortoise) {
+        lam++;
+        //Hash first, then the full compare to rule out collisions
+        if (h == tortoise.hash && pc == tortoise.pc && writeEpoch == tortoise.epoch) {
+            bool same = true;
+            for (int i = 1; i < 32 && same; i++) {
+                same = registers[i] == tortoise.regs[i];
+            }
+            if (same) {
+                loopPC = pc;
+                period = instret - tortoise.instret;
+                return true;
+            }
+        }
+        if (lam != power)
+            return false;
+        power *= 2;
+        lam = 0;
+    }
+
+    //Move the tortoise up to the current observation
+    haveTortoise = true;
+    tortoise.pc = pc;
+    tortoise.regs[0] = 0;
+    for (int i = 1; i < 32; i++) {
+        tortoise.regs[i] = registers[i];
+    }
+    tortoise.epoch = writeEpoch;
+    tortoise.instret = instret;
+    tortoise.hash = h;
+    return false;
+}
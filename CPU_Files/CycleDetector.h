@@ -0,0 +1,41 @@
+#pragma once
+#include "CPU.h"
+
+//////////////////////////////////////////////////////////////////////
+// NON-TERMINATION DETECTION (Brent's cycle finding)
+//
+// Fed with a fingerprint of (PC, registers, memory write epoch) after every
+// taken branch or jump, because any cycle in the guest state has to take
+// at least one. The memory write epoch only moves when a store changes a
+// word, so two observations with equal fingerprints are the same machine
+// state, and the guest is in an infinite loop. Brent's algorithm keeps one
+// saved observation (the tortoise) and doubles the distance to it
+// whenever the distance reaches the current power of two. Memory use is
+// O(1), and the per-observation work is one hash plus an occasional
+// 32-register compare.
+//////////////////////////////////////////////////////////////////////
+
+class CycleDetector {
+public:
+	//Returns true once the current state repeats the saved one
+	bool Observe(unsigned long pc, const int registers[], unsigned long long writeEpoch, unsigned long long instret);
+
+	unsigned long loopPC = 0;      //PC where the repeated state was seen (loop entry)
+	unsigned long long period = 0; //loop length in instructions
+
+private:
+	struct Observation {
+		unsigned long pc;
+		int regs[32];
+		unsigned long long epoch;
+		unsigned long long instret;
+		uint64_t hash;
+	};
+
+	bool haveTortoise = false;
+	Observation tortoise;
+	unsigned long long power = 1;
+	unsigned long long lam = 0;
+
+	static uint64_t Fingerprint(unsigned long pc, const int registers[], unsigned long long writeEpoch);
+};
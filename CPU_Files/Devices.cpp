@@ -0,0 +1,239 @@
+#include "Devices.h"
+#include "Events.h"
+
+#include <cstdlib>
+
+//////////////////////////////////////////////////////////////////////
+// BUS
+//////////////////////////////////////////////////////////////////////
+
+MMIOBus::MMIOBus()
+    : pages(NUM_PAGES)
+{
+}
+
+bool MMIOBus::Map(uint32_t base, uint32_t size, MMIODevice* device)
+{
+    const uint32_t pageMask = (1u << PAGE_BITS) - 1;
+    if (device == nullptr || size == 0 || (base & pageMask) || (size & pageMask))
+        return false;
+    if (base < WINDOW_BASE || base >= WINDOW_END || size > WINDOW_END - base)
+        return false;
+    uint32_t first = (base - WINDOW_BASE) >> PAGE_BITS;
+    uint32_t count = size >> PAGE_BITS;
+    for (uint32_t p = first; p < first + count; p++) {
+        if (pages[p].device)
+            return false;
+    }
+    for (uint32_t p = first; p < first + count; p++) {
+        pages[p].device = device;
+        pages[p].base = base;
+    }
+    return true;
+}
+
+bool MMIOBus::Read(uint32_t addr, bool word, int32_t& value)
+{
+    Page* p = Lookup(addr);
+    if (!p) {
+        unmapped++;
+        value = 0;
+        return false;
+    }
+    value = p->device->Read(addr - p->base, word);
+    return true;
+}
+
+bool MMIOBus::Write(uint32_t addr, int32_t value, bool word)
+{
+    Page* p = Lookup(addr);
+    if (!p) {
+        unmapped++;
+        return false;
+    }
+    p->device->Write(addr - p->base, value, word);
+    return true;
+}
+
+//Byte accesses see the low byte of the word register, like RAM does
+static int32_t Narrow(int32_t value, bool word)
+{
+    return word ? value : (value & 0xFF);
+}
+
+//////////////////////////////////////////////////////////////////////
+// INPUT FIFO
+//////////////////////////////////////////////////////////////////////
+
+bool InputFifo::Load(const char* fileName)
+{
+    ifstream in(fileName);
+    if (!in)
+        return false;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        values.push_back((int32_t)strtol(line.c_str(), nullptr, 0));
+    }
+    return true;
+}
+
+int32_t InputFifo::Read(uint32_t offset, bool word)
+{
+    switch (offset & ~3u) {
+    case 0: {
+        if (values.empty())
+            return Narrow(-1, word);
+        int32_t v = values.front();
+        values.pop_front();
+        return Narrow(v, word);
+    }
+    case 4:
+        return Narrow((int32_t)values.size(), word);
+    default:
+        return 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// UART
+//////////////////////////////////////////////////////////////////////
+
+void Uart::Flush()
+{
+    if (!buffer.empty()) {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+}
+
+int32_t Uart::Read(uint32_t offset, bool word)
+{
+    return (offset & ~3u) == 4 ? Narrow(1, word) : 0;
+}
+
+void Uart::Write(uint32_t offset, int32_t value, bool)
+{
+    if ((offset & ~3u) != 0)
+        return;
+    buffer.push_back((char)(value & 0xFF));
+    bytesWritten++;
+    if (buffer.size() >= 4096)
+        Flush();
+}
+
+//////////////////////////////////////////////////////////////////////
+// TIMER
+//////////////////////////////////////////////////////////////////////
+
+int32_t Timer::Read(uint32_t offset, bool word)
+{
+    switch (offset & ~3u) {
+    case 0: return Narrow((int32_t)(bus.now & 0xFFFFFFFF), word);
+    case 4: return Narrow((int32_t)(bus.now >> 32), word);
+    case 8: return Narrow((int32_t)(compare & 0xFFFFFFFF), word);
+    case 12: return Narrow((int32_t)(compare >> 32), word);
+    case 16: return Pending() ? 1 : 0;
+    default: return 0;
+    }
+}
+
+void Timer::Write(uint32_t offset, int32_t value, bool word)
+{
+    uint32_t v = (uint32_t)value;
+    int shift;
+    switch (offset & ~3u) {
+    case 8: shift = 0; break;
+    case 12: shift = 32; break;
+    default: return; //MTIME follows the instruction count and cannot be set
+    }
+    uint64_t mask = (word ? 0xFFFFFFFFULL : 0xFFULL) << shift;
+    if (!word)
+        v &= 0xFF;
+    compare = (compare & ~mask) | ((uint64_t)v << shift);
+    if (events) {
+        if (eventId)
+            events->Cancel(eventId);
+        eventId = 0;
+        if (compare != ~0ULL) {
+            //Fired events are gone from the wheel: forget the id so a later write does not cancel it
+            eventId = events->Schedule(compare, [this]() {
+                eventId = 0;
+                events->irq.Raise(line);
+            });
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// INTERRUPT CONTROLLER
+//////////////////////////////////////////////////////////////////////
+
+InterruptController::InterruptController()
+{
+    for (int i = 0; i < NUM_LINES; i++) {
+        priority[i] = 1;
+    }
+}
+
+void InterruptController::Raise(int line)
+{
+    pending |= 1u << line;
+    Update();
+}
+
+void InterruptController::Clear(int line)
+{
+    pending &= ~(1u << line);
+    Update();
+}
+
+int InterruptController::HighestPending() const
+{
+    uint32_t ready = pending & enable;
+    int best = -1;
+    for (int i = 0; ready; i++, ready >>= 1) {
+        if ((ready & 1) && priority[i] > threshold && (best < 0 || priority[i] > priority[best]))
+            best = i;
+    }
+    return best;
+}
+
+int32_t InterruptController::Read(uint32_t offset, bool word)
+{
+    offset &= ~3u;
+    switch (offset) {
+    case 0: return Narrow((int32_t)pending, word);
+    case 4: return Narrow((int32_t)enable, word);
+    case 8: {
+        int line = HighestPending();
+        if (line >= 0)
+            Clear(line);
+        return Narrow(line, word);
+    }
+    case 12: return Narrow((int32_t)threshold, word);
+    default:
+        if (offset >= 32 && offset < 32 + 4 * NUM_LINES)
+            return Narrow((int32_t)priority[(offset - 32) / 4], word);
+        return 0;
+    }
+}
+
+void InterruptController::Write(uint32_t offset, int32_t value, bool word)
+{
+    uint32_t v = word ? (uint32_t)value : ((uint32_t)value & 0xFF);
+    offset &= ~3u;
+    switch (offset) {
+    case 0: pending |= v; break;
+    case 4: enable = v; break;
+    case 12: threshold = v; break;
+    case 16: returnRequested = true; break;
+    default:
+        if (offset >= 32 && offset < 32 + 4 * NUM_LINES)
+            priority[(offset - 32) / 4] = v;
+        break;
+    }
+    Update();
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// MEMORY MAPPED DEVICES
+//
+// Data memory covers byte addresses [0, 0x4000). CPU::DataMemory serves
+// those directly after one range check, and hands anything else to the
+// bus. The bus splits the MMIO window [0x4000, 0x14000) into 256 byte
+// pages and keeps one device pointer per page, so dispatch is a shift
+// and an index. Accesses to unmapped addresses read 0, drop stores, and
+// are counted.
+//
+// Stand-in devices (cpusim maps them at these bases):
+//   0x4000 input FIFO  +0 DATA (read pops the next value, -1 when empty), +4 COUNT
+//   0x4100 UART        +0 TX (low byte is written to the host file), +4 STATUS (1 = ready)
+//   0x4200 timer       +0/+4 MTIME lo/hi (instructions retired), +8/+12 MTIMECMP lo/hi,
+//                      +16 PENDING (MTIME >= MTIMECMP)
+//   0x4300 interrupt controller (see InterruptController)
+//////////////////////////////////////////////////////////////////////
+
+class MMIOBus;
+class EventScheduler;
+
+class MMIODevice {
+public:
+	virtual ~MMIODevice() {}
+	virtual string Name() const = 0;
+	//offset is relative to the device's base address
+	virtual int32_t Read(uint32_t offset, bool word) = 0;
+	virtual void Write(uint32_t offset, int32_t value, bool word) = 0;
+};
+
+class MMIOBus {
+public:
+	static const uint32_t WINDOW_BASE = 0x4000;
+	static const uint32_t PAGE_BITS = 8;
+	static const uint32_t NUM_PAGES = 256;
+	static const uint32_t WINDOW_END = WINDOW_BASE + (NUM_PAGES << PAGE_BITS);
+
+	static const uint32_t INPUT_FIFO_BASE = 0x4000; //same address the nondeterministic checker treats as input
+	static const uint32_t UART_BASE = 0x4100;
+	static const uint32_t TIMER_BASE = 0x4200;
+	static const uint32_t IRQ_BASE = 0x4300;
+
+	MMIOBus();
+
+	//Maps [base, base + size) to device. base and size must be page aligned and inside the window,
+	//and the range must be free. The bus does not own the device.
+	bool Map(uint32_t base, uint32_t size, MMIODevice* device);
+
+	//Returns false (and counts it) for unmapped addresses
+	bool Read(uint32_t addr, bool word, int32_t& value);
+	bool Write(uint32_t addr, int32_t value, bool word);
+
+	unsigned long long now = 0;         //guest time (instructions retired), kept current by RunProgram
+	unsigned long long unmapped = 0;    //accesses that hit no device
+
+private:
+	struct Page {
+		MMIODevice* device = nullptr;
+		uint32_t base = 0;
+	};
+	vector<Page> pages;
+
+	Page* Lookup(uint32_t addr)
+	{
+		if (addr - WINDOW_BASE >= WINDOW_END - WINDOW_BASE)
+			return nullptr;
+		Page* p = &pages[(addr - WINDOW_BASE) >> PAGE_BITS];
+		return p->device ? p : nullptr;
+	}
+};
+
+//Values the guest reads one at a time, loaded from a file (one integer per line, decimal or 0x hex)
+class InputFifo : public MMIODevice {
+public:
+	bool Load(const char* fileName);
+	void Push(int32_t value) { values.push_back(value); }
+	string Name() const override { return "input"; }
+	int32_t Read(uint32_t offset, bool word) override;
+	void Write(uint32_t, int32_t, bool) override {}
+
+private:
+	deque<int32_t> values;
+};
+
+//Transmit-only UART. Bytes are buffered and written to the host stream in blocks.
+class Uart : public MMIODevice {
+public:
+	explicit Uart(ostream& out) : out(out) {}
+	~Uart() override { Flush(); }
+	void Flush();
+	string Name() const override { return "uart"; }
+	int32_t Read(uint32_t offset, bool word) override;
+	void Write(uint32_t offset, int32_t value, bool word) override;
+
+	unsigned long long bytesWritten = 0;
+
+private:
+	ostream& out;
+	string buffer;
+};
+
+class Timer : public MMIODevice {
+public:
+	explicit Timer(const MMIOBus& bus) : bus(bus) {}
+	string Name() const override { return "timer"; }
+	int32_t Read(uint32_t offset, bool word) override;
+	void Write(uint32_t offset, int32_t value, bool word) override;
+
+	//Once connected, every MTIMECMP write reschedules an event that raises `line`
+	void Connect(EventScheduler* events, int line) { this->events = events; this->line = line; }
+
+	unsigned long long compare = ~0ULL; //MTIMECMP, never fires until written
+	bool Pending() const { return bus.now >= compare; }
+
+private:
+	const MMIOBus& bus;
+	EventScheduler* events = nullptr;
+	int line = 0;
+	uint64_t eventId = 0; //pending MTIMECMP event, 0 once it fired
+};
+
+//////////////////////////////////////////////////////////////////////
+// INTERRUPT CONTROLLER
+//
+// 32 edge triggered lines. Raise() latches a line's pending bit; the
+// line is delivered when it is pending, enabled, and its priority is
+// above the threshold. Higher priority wins, ties go to the lower line.
+// RunProgram checks for delivery at block boundaries only, and takes
+// the interrupt like the transition system does: x30 = PC of the next
+// instruction, bit 0 of x12 (MSTATUS) cleared, PC = 0x80.
+//
+// Registers (offsets from IRQ_BASE):
+//   +0  PENDING    read pending bits, write 1s to raise lines from software
+//   +4  ENABLE     mask of lines that may be delivered
+//   +8  CLAIM      read: highest deliverable line, clearing its pending bit (-1 if none)
+//   +12 THRESHOLD  only priorities above this are delivered
+//   +16 MRET       any write returns from the handler: PC = x30, MSTATUS bit 0 set
+//   +32 + 4*n      PRIORITY of line n
+//////////////////////////////////////////////////////////////////////
+
+class InterruptController : public MMIODevice {
+public:
+	static const int NUM_LINES = 32;
+	static const int TIMER_LINE = 0;
+	static const int MSTATUS_REG = 12;             //bit 0 enables delivery
+	static const int EPC_REG = 30;
+	static const unsigned long HANDLER_ADDR = 0x80;
+
+	InterruptController();
+	string Name() const override { return "irq"; }
+	int32_t Read(uint32_t offset, bool word) override;
+	void Write(uint32_t offset, int32_t value, bool word) override;
+
+	void Raise(int line);
+	void Clear(int line);
+	//Highest priority line that may be delivered, -1 if none
+	int HighestPending() const;
+	bool Deliverable() const { return deliverable; }
+	//True once after the guest wrote MRET
+	bool TakeReturn() { bool r = returnRequested; returnRequested = false; return r; }
+
+	uint32_t pending = 0;
+	uint32_t enable = 0;
+	uint32_t threshold = 0;
+	uint32_t priority[NUM_LINES];
+
+private:
+	bool deliverable = false; //cached HighestPending() >= 0, kept current by every change
+	bool returnRequested = false;
+	void Update() { deliverable = HighestPending() >= 0; }
+};
@@ -0,0 +1,124 @@
+#include "Events.h"
+#include "Devices.h"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////
+// TIMER WHEEL
+//////////////////////////////////////////////////////////////////////
+
+uint64_t TimerWheel::Schedule(unsigned long long when, function<void()> fire)
+{
+    Event e;
+    e.when = when;
+    e.id = nextId++;
+    e.fire = fire;
+    Insert(e);
+    return e.id;
+}
+
+void TimerWheel::Insert(Event e)
+{
+    if (e.when <= now) {
+        due.push_back(e);
+        return;
+    }
+    //Level = highest 6-bit digit where `when` and `now` differ
+    for (int level = LEVELS - 1; level >= 0; level--) {
+        if ((e.when >> (SLOT_BITS * level)) != (now >> (SLOT_BITS * level))) {
+            if ((e.when >> (SLOT_BITS * (level + 1))) != (now >> (SLOT_BITS * (level + 1))))
+                break; //differs above the top level
+            slots[level][Digit(e.when, level)].push_back(e);
+            return;
+        }
+    }
+    overflow.push_back(e);
+}
+
+unsigned long long TimerWheel::NextEventTime() const
+{
+    if (!due.empty())
+        return now;
+    //Everything at a lower level is earlier than anything above it
+    for (int level = 0; level < LEVELS; level++) {
+        int first = level == 0 ? Digit(now, 0) : Digit(now, level) + 1;
+        for (int s = first; s < SLOTS; s++) {
+            if (slots[level][s].empty())
+                continue;
+            unsigned long long best = NEVER;
+            for (const Event& e : slots[level][s]) {
+                best = min(best, e.when);
+            }
+            return best;
+        }
+    }
+    unsigned long long best = NEVER;
+    for (const Event& e : overflow) {
+        best = min(best, e.when);
+    }
+    return best;
+}
+
+//Only called with no event strictly between now and t, so the slots passed over are empty.
+//Events in the slot t enters at each level move down, top level first.
+void TimerWheel::MoveTo(unsigned long long t)
+{
+    bool crossedTop = (t >> (SLOT_BITS * LEVELS)) != (now >> (SLOT_BITS * LEVELS));
+    now = t;
+    if (crossedTop) {
+        vector<Event> pending;
+        pending.swap(overflow);
+        for (Event& e : pending) {
+            Insert(e);
+        }
+    }
+    for (int level = LEVELS - 1; level >= 1; level--) {
+        vector<Event> pending;
+        pending.swap(slots[level][Digit(t, level)]);
+        for (Event& e : pending) {
+            Insert(e);
+        }
+    }
+    vector<Event>& here = slots[0][Digit(t, 0)];
+    for (Event& e : here) {
+        due.push_back(e);
+    }
+    here.clear();
+}
+
+void TimerWheel::Advance(unsigned long long to)
+{
+    while (true) {
+        unsigned long long next = NextEventTime();
+        if (next > to) {
+            if (to > now)
+                MoveTo(to);
+            return;
+        }
+        if (next > now)
+            MoveTo(next);
+        vector<Event> firing;
+        firing.swap(due);
+        for (Event& e : firing) {
+            if (cancelled.erase(e.id) == 0)
+                e.fire(); //may schedule more events
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// SCHEDULER
+//////////////////////////////////////////////////////////////////////
+
+uint64_t EventScheduler::Schedule(unsigned long long when, function<void()> fire)
+{
+    uint64_t id = wheel.Schedule(when, fire);
+    nextDue = min(nextDue, max(when, wheel.now));
+    return id;
+}
+
+void EventScheduler::Advance(unsigned long long now)
+{
+    wheel.Advance(now);
+    nextDue = wheel.NextEventTime();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// TIMED EVENTS
+//
+// Guest time is the number of instructions retired. TimerWheel keeps
+// future events in a hierarchical wheel: 4 levels of 64 slots, each
+// level 64 times coarser than the one below. An event sits at the level
+// of the highest 6-bit digit where its time differs from `now`, and
+// moves down as time approaches it. Scheduling is O(1), and finding the
+// next event scans at most 64 slots per level. Events beyond the 2^24
+// tick window wait in an overflow list.
+//
+// The run loop only calls into the scheduler at block boundaries, and
+// only when `now` has reached nextDue. With no pending events the cost
+// per block is one compare.
+//////////////////////////////////////////////////////////////////////
+
+class TimerWheel {
+public:
+	static const int LEVELS = 4;
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = 1 << SLOT_BITS;
+	static const unsigned long long NEVER = ~0ULL;
+
+	//Returns an id for Cancel. Events at or before now fire on the next Advance.
+	//Cancel only ids still pending: a fired id would stay in `cancelled` for good.
+	uint64_t Schedule(unsigned long long when, function<void()> fire);
+	void Cancel(uint64_t id) { cancelled.insert(id); }
+
+	//Moves time forward to `to`, firing every event due on the way in time order
+	void Advance(unsigned long long to);
+	//Earliest scheduled time (NEVER if none); cancelled events may still be counted
+	unsigned long long NextEventTime() const;
+
+	unsigned long long now = 0;
+
+private:
+	struct Event {
+		unsigned long long when;
+		uint64_t id;
+		function<void()> fire;
+	};
+	vector<Event> slots[LEVELS][SLOTS];
+	vector<Event> overflow;
+	vector<Event> due;
+	unordered_set<uint64_t> cancelled;
+	uint64_t nextId = 1;
+
+	static int Digit(unsigned long long t, int level) { return (int)((t >> (SLOT_BITS * level)) & (SLOTS - 1)); }
+	void Insert(Event e);
+	void MoveTo(unsigned long long t);
+};
+
+class InterruptController;
+
+//Timer wheel plus the interrupt controller the events raise lines on
+class EventScheduler {
+public:
+	explicit EventScheduler(InterruptController& irq) : irq(irq) {}
+
+	uint64_t Schedule(unsigned long long when, function<void()> fire);
+	void Cancel(uint64_t id) { wheel.Cancel(id); }
+	//Fires everything due up to `now`
+	void Advance(unsigned long long now);
+
+	InterruptController& irq;
+	unsigned long long nextDue = TimerWheel::NEVER; //cached wheel.NextEventTime()
+	unsigned long long interruptsTaken = 0;
+
+private:
+	TimerWheel wheel;
+};
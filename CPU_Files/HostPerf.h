@@ -0,0 +1,121 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////
+// HOST SELF-PROFILING
+//
+// Reads the host's hardware counters (Linux perf_event_open) around a run
+// and relates them to the guest work done: host cycles per guest
+// instruction, IPC, branch miss rate and last level cache misses. Counters
+// inherit into threads created after Start(), so multi-hart runs are
+// covered too. When the counters cannot be opened (not Linux, no PMU in a
+// VM, perf_event_paranoid too strict) only wall-clock time is reported.
+//
+// The counters are opened as one group, so the PMU schedules them together
+// and the ratios compare counts over the same windows. If the PMU still
+// has to multiplex, each count is scaled by its enabled / running time.
+//////////////////////////////////////////////////////////////////////
+
+class HostPerf {
+public:
+	enum Counter { CYCLES, INSTRUCTIONS, BRANCHES, BRANCH_MISSES, LLC_MISSES, NUM_COUNTERS };
+
+	HostPerf() {
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			fds[c] = -1;
+			values[c] = 0;
+		}
+	}
+
+	~HostPerf() {
+#ifdef __linux__
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			if (fds[c] >= 0) close(fds[c]);
+		}
+#endif
+	}
+
+	void Start() {
+#ifdef __linux__
+		const uint64_t configs[NUM_COUNTERS] = {
+			PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+			PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES };
+		//The first counter that opens leads the group, the rest join it
+		leader = -1;
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = configs[c];
+			attr.disabled = leader < 0;
+			attr.inherit = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			fds[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+			if (leader < 0 && fds[c] >= 0) leader = fds[c];
+		}
+		if (leader >= 0) {
+			ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+#endif
+		start = std::chrono::steady_clock::now();
+	}
+
+	void Stop() {
+		end = std::chrono::steady_clock::now();
+#ifdef __linux__
+		if (leader >= 0) ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		for (int c = 0; c < NUM_COUNTERS; c++) {
+			if (fds[c] < 0) continue;
+			uint64_t v[3] = { 0, 0, 0 }; //value, time enabled, time running
+			if (read(fds[c], v, sizeof(v)) == (ssize_t)sizeof(v) && v[2] > 0) {
+				values[c] = v[2] < v[1] ? (uint64_t)((double)v[0] * v[1] / v[2]) : v[0];
+			}
+			else { close(fds[c]); fds[c] = -1; } //never scheduled on the PMU
+		}
+#endif
+	}
+
+	bool Has(Counter c) const { return fds[c] >= 0; }
+
+	// guestWork: guest instructions (or states) executed between Start and Stop
+	void Report(std::ostream& out, unsigned long long guestWork, const std::string& unit = "guest instruction") const {
+		double seconds = std::chrono::duration<double>(end - start).count();
+		out << "[PERF] wall time: " << seconds * 1e3 << " ms";
+		if (guestWork > 0) out << ", " << seconds * 1e9 / guestWork << " ns per " << unit;
+		out << std::endl;
+
+		if (!Has(CYCLES) && !Has(INSTRUCTIONS)) {
+			out << "[PERF] hardware counters unavailable, wall-clock timing only" << std::endl;
+			return;
+		}
+		if (Has(CYCLES) && guestWork > 0)
+			out << "[PERF] host cycles per " << unit << ": " << (double)values[CYCLES] / guestWork << std::endl;
+		if (Has(CYCLES) && Has(INSTRUCTIONS) && values[CYCLES] > 0)
+			out << "[PERF] host IPC: " << (double)values[INSTRUCTIONS] / values[CYCLES] << std::endl;
+		if (Has(BRANCHES) && Has(BRANCH_MISSES) && values[BRANCHES] > 0)
+			out << "[PERF] branch miss rate: " << 100.0 * values[BRANCH_MISSES] / values[BRANCHES] << " %" << std::endl;
+		if (Has(LLC_MISSES))
+			out << "[PERF] LLC misses: " << values[LLC_MISSES] << std::endl;
+	}
+
+private:
+	int fds[NUM_COUNTERS];
+	int leader = -1;
+	uint64_t values[NUM_COUNTERS];
+	std::chrono::steady_clock::time_point start, end;
+};
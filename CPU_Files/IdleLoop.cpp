@@ -0,0 +1,51 @@
+#include "IdleLoop.h"
+
+IdleLoopDetector::Block IdleLoopDetector::Predecode(unsigned char instMem[], unsigned long head, unsigned long tail)
+{
+    Block block;
+    for (unsigned long pc = head; pc <= tail; pc += 4) {
+        Instruction inst(instMem, pc);
+        Controller ctrl(inst);
+        int rd = (inst.instr.to_ulong() >> 7) & 0x1F;
+        int rs1 = (inst.instr.to_ulong() >> 15) & 0x1F;
+        int rs2 = (inst.instr.to_ulong() >> 20) & 0x1F;
+
+        if ((ctrl.regWrite && rd != 0) || ctrl.MemWr) {
+            block.writesState = true;
+        }
+        //Inner control flow: BEQ is fine if it falls through, JAL always leaves the block
+        if (pc != tail && ctrl.Branch) {
+            if (ctrl.opcode == bitset<7>(0b1100011))
+                block.innerBranches.push_back(make_pair(rs1, rs2));
+            else
+                block.writesState = true;
+        }
+    }
+    return block;
+}
+
+bool IdleLoopDetector::IsIdleLoop(unsigned char instMem[], int maxPC, unsigned long head, unsigned long tail, const int registers[])
+{
+    if (head > tail || tail + 4 > (unsigned long)maxPC)
+        return false;
+    //A misaligned target would be decoded across instruction boundaries
+    if (head % 4 != 0 || (tail - head) % 4 != 0)
+        return false;
+
+    pair<unsigned long, unsigned long> key = make_pair(head, tail);
+    map<pair<unsigned long, unsigned long>, Block>::iterator it = blocks.find(key);
+    if (it == blocks.end()) {
+        it = blocks.insert(make_pair(key, Predecode(instMem, head, tail))).first;
+    }
+
+    const Block& block = it->second;
+    if (block.writesState)
+        return false;
+    for (const pair<int, int>& br : block.innerBranches) {
+        int rs1Val = br.first ? registers[br.first] : 0;
+        int rs2Val = br.second ? registers[br.second] : 0;
+        if (rs1Val == rs2Val)
+            return false; //taken: leaves the straight line block
+    }
+    return true;
+}
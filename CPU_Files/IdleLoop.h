@@ -0,0 +1,33 @@
+#pragma once
+#include "CPU.h"
+#include <map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// IDLE LOOP DETECTION
+//
+// Called when a branch/jump at `tail` goes back to `head`. The block
+// [head, tail] is predecoded once and cached. The loop provably never
+// changes state when
+//   * no instruction in the block writes a register other than x0,
+//   * no instruction stores to memory,
+//   * the only jump is the closing instruction at `tail`, and
+//   * every BEQ inside the block falls through under the current registers.
+// The register file cannot change, so every later iteration takes the
+// same path back to `head` and the guest spins forever (e.g.
+// `beq x0,x0,0` or `jal x0,0`).
+//////////////////////////////////////////////////////////////////////
+
+class IdleLoopDetector {
+public:
+	bool IsIdleLoop(unsigned char instMem[], int maxPC, unsigned long head, unsigned long tail, const int registers[]);
+
+private:
+	struct Block {
+		bool writesState = false;           //register write, store or inner jump
+		vector<pair<int, int>> innerBranches; //(rs1, rs2) of each BEQ before the tail
+	};
+	map<pair<unsigned long, unsigned long>, Block> blocks;
+
+	Block Predecode(unsigned char instMem[], unsigned long head, unsigned long tail);
+};
@@ -0,0 +1,387 @@
+#include "MultiHart.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//////////////////////////////////////////////////////////////////////
+//SHARED MEMORY
+//////////////////////////////////////////////////////////////////////
+
+SharedMemory::SharedMemory()
+{
+    for (int i = 0; i < NUM_WORDS; i++) {
+        words[i].store(0, memory_order_relaxed);
+    }
+}
+
+int32_t SharedMemory::Load(int addr, bool word)
+{
+    if (!InRange(addr))
+        return 0;
+    int32_t value = words[addr / 4].load(memory_order_seq_cst);
+    //Same as CPU::DataMemory: a byte load returns the low byte of the word
+    return word ? value : (value & 0xFF);
+}
+
+void SharedMemory::Store(int addr, int32_t value, bool word)
+{
+    if (!InRange(addr))
+        return;
+    //Same as CPU::DataMemory: a byte store writes the low byte into the whole word
+    words[addr / 4].store(word ? value : (value & 0xFF), memory_order_seq_cst);
+}
+
+int32_t SharedMemory::AmoSwap(int addr, int32_t value)
+{
+    if (!InRange(addr))
+        return 0;
+    return words[addr / 4].exchange(value, memory_order_seq_cst);
+}
+
+int32_t SharedMemory::AmoAdd(int addr, int32_t value)
+{
+    if (!InRange(addr))
+        return 0;
+    return words[addr / 4].fetch_add(value, memory_order_seq_cst);
+}
+
+bool SharedMemory::CompareAndSwap(int addr, int32_t expected, int32_t desired)
+{
+    if (!InRange(addr))
+        return false;
+    return words[addr / 4].compare_exchange_strong(expected, desired, memory_order_seq_cst);
+}
+
+//////////////////////////////////////////////////////////////////////
+//STORE BUFFER (deterministic quantum mode)
+//////////////////////////////////////////////////////////////////////
+
+BufferedMemory::BufferedMemory(SharedMemory& sharedMem)
+    : shared(&sharedMem), shadow(SharedMemory::NUM_WORDS, 0), written(SharedMemory::NUM_WORDS, false)
+{
+}
+
+int32_t BufferedMemory::Load(int addr, bool word)
+{
+    if (!SharedMemory::InRange(addr))
+        return 0;
+    //A hart sees its own buffered stores, everything else comes from the quantum start
+    if (written[addr / 4]) {
+        int32_t value = shadow[addr / 4];
+        return word ? value : (value & 0xFF);
+    }
+    return shared->Load(addr, word);
+}
+
+void BufferedMemory::Store(int addr, int32_t value, bool word)
+{
+    if (!SharedMemory::InRange(addr))
+        return;
+    int index = addr / 4;
+    if (!written[index]) {
+        written[index] = true;
+        dirty.push_back(index);
+    }
+    shadow[index] = word ? value : (value & 0xFF);
+}
+
+void BufferedMemory::Commit()
+{
+    for (int index : dirty) {
+        shared->PokeWord(index, shadow[index]);
+        written[index] = false;
+    }
+    dirty.clear();
+}
+
+//Reusable barrier for the worker threads (std::barrier needs C++20)
+class QuantumBarrier {
+public:
+    QuantumBarrier(int count) : total(count) {}
+
+    void Wait()
+    {
+        unique_lock<mutex> lock(m);
+        unsigned long long gen = generation;
+        if (++arrived == total) {
+            arrived = 0;
+            generation++;
+            cv.notify_all();
+        }
+        else {
+            cv.wait(lock, [&]() { return gen != generation; });
+        }
+    }
+
+private:
+    mutex m;
+    condition_variable cv;
+    int total;
+    int arrived = 0;
+    unsigned long long generation = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+//HART
+//////////////////////////////////////////////////////////////////////
+
+Hart::Hart(int hartId)
+{
+    id = hartId;
+    PC = 0;
+    for (int i = 0; i < 32; i++) {
+        registers[i] = 0;
+    }
+    //Boot convention: a0 holds the hart id so guest code can split work
+    registers[10] = hartId;
+}
+
+bool Hart::Step(unsigned char instMem[], int maxPC, HartMemory& mem, bool atomics)
+{
+    //Same fetch limits as the single hart loop in cpusim
+    if (halted || PC + 4 > (unsigned long)maxPC) {
+        halted = true;
+        return false;
+    }
+
+    ///////////////
+    //// FETCH ////
+    ///////////////
+    Instruction myInst(instMem, PC);
+    unsigned long nextPC = PC + 4;
+
+    //ATOMICS (not known to Controller, so decode them here)
+    if (atomics && (myInst.instr & bitset<32>(0x7F)) == bitset<32>(0b0101111)) {
+        ExecuteAtomic(myInst, mem);
+        registers[0] = 0;
+        PC = nextPC;
+        instret++;
+        return true;
+    }
+
+    ////////////////
+    //// DECODE	////
+    ////////////////
+    Controller myController(myInst);
+    ALU_Controller myALU_Control(myInst, myController.ALUOp);
+    int32_t ImmValue = ImmGen(myInst);
+
+    int rd = (myInst.instr.to_ulong() >> 7) & 0x1F;
+    int rs1 = (myInst.instr.to_ulong() >> 15) & 0x1F;
+    int rs2 = (myInst.instr.to_ulong() >> 20) & 0x1F;
+
+    ////////////////
+    // EXECUTION  //
+    ////////////////
+    registers[0] = 0;
+    int rs1Val = registers[rs1];
+    int prevRS2 = registers[rs2];
+    int rs2Val = myController.AluSrc ? ImmValue : prevRS2;
+
+    int32_t ALU_Res = ALU_Result(rs1Val, rs2Val, myALU_Control.ALUOp);
+    bool zeroFlag = ALU_Res ? 0 : 1;
+    if (myController.Branch && zeroFlag) {
+        nextPC = PC + ImmValue;
+    }
+
+    /////////////////
+    //MEMORY ACCESS//
+    /////////////////
+    bool isWord = (myInst.instr & bitset<32>(0x7000)) == bitset<32>(0x2000);
+    int32_t Read_Data = 0;
+    if (myController.MemWr) {
+        mem.Store(ALU_Res, prevRS2, isWord);
+    }
+    else if (myController.MemRe) {
+        Read_Data = mem.Load(ALU_Res, isWord);
+    }
+
+    //////////////
+    //WRITE BACK//
+    //////////////
+    if (myController.regWrite && rd != 0) {
+        if (myController.opcode == bitset<7>(0b1101111)) {
+            registers[rd] = PC + 4;
+        }
+        else {
+            registers[rd] = myController.MemtoReg ? Read_Data : ALU_Res;
+        }
+    }
+
+    PC = nextPC;
+    instret++;
+    if (PC > (unsigned long)maxPC)
+        halted = true;
+    return true;
+}
+
+bool Hart::AtAtomic(unsigned char instMem[], int maxPC)
+{
+    if (halted || PC + 4 > (unsigned long)maxPC)
+        return false;
+    Instruction myInst(instMem, PC);
+    return (myInst.instr & bitset<32>(0x7F)) == bitset<32>(0b0101111);
+}
+
+void Hart::ExecuteAtomic(Instruction& inst, HartMemory& mem)
+{
+    uint32_t raw = inst.instr.to_ulong();
+    int rd = (raw >> 7) & 0x1F;
+    int rs1 = (raw >> 15) & 0x1F;
+    int rs2 = (raw >> 20) & 0x1F;
+    uint32_t funct3 = (raw >> 12) & 0x7;
+    uint32_t funct5 = (raw >> 27) & 0x1F;
+
+    //Only the word sized forms exist in this subset
+    if (funct3 != 0x2)
+        return;
+
+    registers[0] = 0;
+    int addr = registers[rs1];
+    int32_t value = registers[rs2];
+    int32_t result = 0;
+
+    if (funct5 == 0b00010) {        //LR.W
+        result = mem.Load(addr, true);
+        reservationValid = true;
+        reservationAddr = addr;
+        reservationValue = result;
+    }
+    else if (funct5 == 0b00011) {   //SC.W
+        bool success = reservationValid && reservationAddr == addr
+            && mem.CompareAndSwap(addr, reservationValue, value);
+        reservationValid = false;
+        result = success ? 0 : 1;
+    }
+    else if (funct5 == 0b00001) {   //AMOSWAP.W
+        result = mem.AmoSwap(addr, value);
+    }
+    else if (funct5 == 0b00000) {   //AMOADD.W
+        result = mem.AmoAdd(addr, value);
+    }
+    else {
+        return;
+    }
+
+    if (rd != 0)
+        registers[rd] = result;
+}
+
+//////////////////////////////////////////////////////////////////////
+//SCHEDULING
+//////////////////////////////////////////////////////////////////////
+
+static bool BudgetLeft(const Hart& hart, unsigned long long maxSteps)
+{
+    return maxSteps == 0 || hart.instret < maxSteps;
+}
+
+//Parallel quantum mode: see the description in MultiHart.h
+static void RunDeterministicQuantum(vector<Hart>& harts, unsigned char instMem[], int maxPC, const MultiHartConfig& config, SharedMemory& mem)
+{
+    int numHarts = (int)harts.size();
+    int numThreads = config.numThreads;
+    if (numThreads <= 0) {
+        numThreads = (int)thread::hardware_concurrency();
+        if (numThreads <= 0)
+            numThreads = 1;
+    }
+    if (numThreads > numHarts)
+        numThreads = numHarts;
+
+    vector<BufferedMemory> buffers;
+    for (int h = 0; h < numHarts; h++) {
+        buffers.push_back(BufferedMemory(mem));
+    }
+
+    QuantumBarrier barrier(numThreads);
+    bool done = false;
+
+    auto worker = [&](int t) {
+        while (true) {
+            //PARALLEL PHASE: shared memory is read only, stores go to the buffers
+            for (int h = t; h < numHarts; h += numThreads) {
+                Hart& hart = harts[h];
+                for (int q = 0; q < config.detQuantum && BudgetLeft(hart, config.maxSteps); q++) {
+                    if (config.atomics && hart.AtAtomic(instMem, maxPC)) {
+                        hart.waitingOnAtomic = true;
+                        break;
+                    }
+                    if (!hart.Step(instMem, maxPC, buffers[h], config.atomics))
+                        break;
+                }
+            }
+            barrier.Wait();
+
+            //COMMIT PHASE: one thread, fixed hart order
+            if (t == 0) {
+                done = true;
+                for (int h = 0; h < numHarts; h++) {
+                    Hart& hart = harts[h];
+                    buffers[h].Commit();
+                    if (hart.waitingOnAtomic) {
+                        hart.waitingOnAtomic = false;
+                        hart.Step(instMem, maxPC, mem, config.atomics);
+                    }
+                    if (!hart.halted && BudgetLeft(hart, config.maxSteps))
+                        done = false;
+                }
+            }
+            barrier.Wait();
+            if (done)
+                return;
+        }
+    };
+
+    vector<thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (thread& th : threads) {
+        th.join();
+    }
+}
+
+vector<Hart> RunMultiHart(unsigned char instMem[], int maxPC, const MultiHartConfig& config, SharedMemory& mem)
+{
+    vector<Hart> harts;
+    for (int h = 0; h < config.numHarts; h++) {
+        harts.push_back(Hart(h));
+    }
+
+    if (config.detQuantum > 0) {
+        RunDeterministicQuantum(harts, instMem, maxPC, config, mem);
+        return harts;
+    }
+
+    if (config.rrQuantum > 0) {
+        //Deterministic: harts take turns on this thread, rrQuantum instructions each
+        bool anyRunning = true;
+        while (anyRunning) {
+            anyRunning = false;
+            for (Hart& hart : harts) {
+                for (int q = 0; q < config.rrQuantum && BudgetLeft(hart, config.maxSteps); q++) {
+                    if (!hart.Step(instMem, maxPC, mem, config.atomics))
+                        break;
+                }
+                if (!hart.halted && BudgetLeft(hart, config.maxSteps))
+                    anyRunning = true;
+            }
+        }
+        return harts;
+    }
+
+    //Free running: one host thread per hart, interleaving decided by the host
+    vector<thread> threads;
+    for (Hart& hart : harts) {
+        threads.emplace_back([&hart, &mem, &config, instMem, maxPC]() {
+            while (BudgetLeft(hart, config.maxSteps) && hart.Step(instMem, maxPC, mem, config.atomics)) {
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    return harts;
+}
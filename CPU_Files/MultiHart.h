@@ -0,0 +1,120 @@
+#pragma once
+#include "CPU.h"
+#include <atomic>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////
+// MULTI-HART SIMULATION
+//
+// Every hart has its own PC and register file and all harts share one
+// data memory. Memory ordering model: each 32-bit word is a std::atomic
+// and every access is seq_cst, so all harts observe a single global order
+// of loads, stores and AMOs (sequential consistency). Accesses outside
+// the 4096-word memory are ignored and read as 0.
+//
+// Optional atomics subset (opcode 0x2F, funct3 = 010, RV32A encoding):
+//   LR.W  rd, (rs1)        funct5 = 00010
+//   SC.W  rd, rs2, (rs1)   funct5 = 00011  (rd = 0 on success, 1 on failure)
+//   AMOSWAP.W rd, rs2, (rs1) funct5 = 00001
+//   AMOADD.W  rd, rs2, (rs1) funct5 = 00000
+// SC succeeds if the word still holds the value seen by LR (compare and swap).
+//
+// Deterministic quantum mode (--det-quantum Q): harts run in parallel for Q
+// instructions against the memory as it was at the start of the quantum,
+// with their own stores held in a private store buffer. At the quantum
+// boundary all threads synchronize and the buffers are committed in hart id
+// order; a hart that reached an atomic stops early and executes it during
+// the commit, again in hart id order. The result only depends on Q, never on
+// host timing or on the number of host threads.
+//////////////////////////////////////////////////////////////////////
+
+//What a hart sees as data memory
+class HartMemory {
+public:
+	virtual ~HartMemory() {}
+	virtual int32_t Load(int addr, bool word) = 0;
+	virtual void Store(int addr, int32_t value, bool word) = 0;
+	virtual int32_t AmoSwap(int addr, int32_t value) = 0;
+	virtual int32_t AmoAdd(int addr, int32_t value) = 0;
+	virtual bool CompareAndSwap(int addr, int32_t expected, int32_t desired) = 0;
+};
+
+class SharedMemory : public HartMemory {
+public:
+	static const int NUM_WORDS = 4096;
+
+	SharedMemory();
+	int32_t Load(int addr, bool word) override;
+	void Store(int addr, int32_t value, bool word) override;
+	int32_t AmoSwap(int addr, int32_t value) override;
+	int32_t AmoAdd(int addr, int32_t value) override;
+	bool CompareAndSwap(int addr, int32_t expected, int32_t desired) override;
+
+	//Plain word access for the commit phase (no other hart is running)
+	int32_t PeekWord(int index) { return words[index].load(memory_order_relaxed); }
+	void PokeWord(int index, int32_t value) { words[index].store(value, memory_order_relaxed); }
+
+	static bool InRange(int addr) { return addr >= 0 && addr / 4 < NUM_WORDS; }
+
+private:
+	std::atomic<int32_t> words[NUM_WORDS];
+};
+
+//Per-hart store buffer used by the deterministic quantum mode
+class BufferedMemory : public HartMemory {
+public:
+	BufferedMemory(SharedMemory& shared);
+	int32_t Load(int addr, bool word) override;
+	void Store(int addr, int32_t value, bool word) override;
+	//Atomics are only ever executed on SharedMemory during the commit phase
+	int32_t AmoSwap(int addr, int32_t value) override { return shared->AmoSwap(addr, value); }
+	int32_t AmoAdd(int addr, int32_t value) override { return shared->AmoAdd(addr, value); }
+	bool CompareAndSwap(int addr, int32_t expected, int32_t desired) override { return shared->CompareAndSwap(addr, expected, desired); }
+
+	void Commit(); //write buffered stores to shared memory and empty the buffer
+
+private:
+	SharedMemory* shared;
+	vector<int32_t> shadow;   //buffered value per word
+	vector<bool> written;     //word has a buffered value
+	vector<int> dirty;        //indices of buffered words
+};
+
+class Hart {
+public:
+	Hart(int hartId);
+
+	int id;
+	unsigned long PC;
+	int registers[32];
+	bool halted = false;
+	unsigned long long instret = 0; //instructions retired
+
+	//LR/SC reservation
+	bool reservationValid = false;
+	int reservationAddr = 0;
+	int32_t reservationValue = 0;
+
+	//Set when the hart stopped at an atomic that has to run in the commit phase
+	bool waitingOnAtomic = false;
+
+	//Execute one instruction. Returns false once the hart has run off the end of the program.
+	bool Step(unsigned char instMem[], int maxPC, HartMemory& mem, bool atomics);
+	bool AtAtomic(unsigned char instMem[], int maxPC);
+
+private:
+	void ExecuteAtomic(Instruction& inst, HartMemory& mem);
+};
+
+struct MultiHartConfig {
+	int numHarts = 1;
+	bool atomics = false;
+	int rrQuantum = 0;                //>0: deterministic round robin on one host thread
+	int detQuantum = 0;               //>0: deterministic parallel quantum mode
+	int numThreads = 0;               //host threads for the quantum mode, 0 = one per hart (capped by cores)
+	unsigned long long maxSteps = 0;  //per-hart instruction budget, 0 = unlimited
+};
+
+//Runs every hart to completion and returns them (registers hold the final state)
+vector<Hart> RunMultiHart(unsigned char instMem[], int maxPC, const MultiHartConfig& config, SharedMemory& mem);
@@ -0,0 +1,163 @@
+#include "Replay.h"
+
+#include <fstream>
+#include <sstream>
+
+//////////////////////////////////////////////////////////////////////
+// LOG FILE
+//////////////////////////////////////////////////////////////////////
+
+bool ReplayLog::Load(const char* fileName)
+{
+    ifstream in(fileName);
+    if (!in)
+        return false;
+    string line;
+    while (getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != string::npos)
+            line.resize(hash);
+        istringstream fields(line);
+        string tag;
+        if (!(fields >> tag))
+            continue;
+        ReplayEvent e;
+        e.value = 0;
+        if (tag == "I") {
+            e.kind = REPLAY_INPUT;
+            if (!(fields >> e.instret >> e.arg >> e.value))
+                return false;
+        }
+        else if (tag == "Q") {
+            e.kind = REPLAY_IRQ;
+            if (!(fields >> e.instret >> e.arg))
+                return false;
+        }
+        else {
+            return false;
+        }
+        events.push_back(e);
+    }
+    return true;
+}
+
+bool ReplayLog::Save(const char* fileName) const
+{
+    ofstream out(fileName);
+    if (!out)
+        return false;
+    out << "# cpusim replay log: I <instret> <offset> <value> | Q <instret> <line>\n";
+    for (const ReplayEvent& e : events) {
+        if (e.kind == REPLAY_INPUT)
+            out << "I " << e.instret << " " << e.arg << " " << e.value << "\n";
+        else
+            out << "Q " << e.instret << " " << e.arg << "\n";
+    }
+    return (bool)out;
+}
+
+//////////////////////////////////////////////////////////////////////
+// SESSION
+//////////////////////////////////////////////////////////////////////
+
+ReplaySession::ReplaySession(ReplayLog& log, bool replaying, const MMIOBus& bus)
+    : replaying(replaying), log(log), bus(bus)
+{
+    if (replaying) {
+        nextInput = SeekInput(0);
+        SeekIrq();
+    }
+}
+
+MMIODevice* ReplaySession::InputPort(MMIODevice* source)
+{
+    ports.emplace_back(*this, source);
+    return &ports.back();
+}
+
+size_t ReplaySession::SeekInput(size_t from) const
+{
+    while (from < log.events.size() && log.events[from].kind != REPLAY_INPUT) {
+        from++;
+    }
+    return from;
+}
+
+void ReplaySession::SeekIrq()
+{
+    while (nextIrqIndex < log.events.size() && log.events[nextIrqIndex].kind != REPLAY_IRQ) {
+        nextIrqIndex++;
+    }
+    nextIrq = nextIrqIndex < log.events.size() ? log.events[nextIrqIndex].instret : NEVER;
+}
+
+void ReplaySession::Diverge(const string& why)
+{
+    if (divergence.empty())
+        divergence = why;
+}
+
+int ReplaySession::TakeInterrupt(unsigned long long instret)
+{
+    if (nextIrq != instret) {
+        Diverge("interrupt taken at instruction " + to_string(instret) + " is not in the log");
+        return -1;
+    }
+    int line = log.events[nextIrqIndex].arg;
+    nextIrqIndex++;
+    SeekIrq();
+    return line;
+}
+
+void ReplaySession::RecordInterrupt(unsigned long long instret, int line)
+{
+    ReplayEvent e;
+    e.instret = instret;
+    e.kind = REPLAY_IRQ;
+    e.arg = line;
+    e.value = 0;
+    log.events.push_back(e);
+}
+
+void ReplaySession::Finish()
+{
+    if (!replaying)
+        return;
+    if (nextInput < log.events.size())
+        Diverge("run ended before the input read logged at instruction " + to_string(log.events[nextInput].instret));
+    else if (nextIrq != NEVER)
+        Diverge("run ended before the interrupt logged at instruction " + to_string(nextIrq));
+}
+
+int32_t ReplaySession::Port::Read(uint32_t offset, bool word)
+{
+    ReplaySession& s = session;
+    if (!s.replaying) {
+        int32_t value = source ? source->Read(offset, word) : 0;
+        ReplayEvent e;
+        e.instret = s.bus.now;
+        e.kind = REPLAY_INPUT;
+        e.arg = (int32_t)offset;
+        e.value = value;
+        s.log.events.push_back(e);
+        return value;
+    }
+    if (s.nextInput >= s.log.events.size()) {
+        s.Diverge("input read at instruction " + to_string(s.bus.now) + " past the end of the log");
+        return -1;
+    }
+    const ReplayEvent& e = s.log.events[s.nextInput];
+    if (e.instret != s.bus.now || e.arg != (int32_t)offset) {
+        s.Diverge("input read at instruction " + to_string(s.bus.now) + " offset " + to_string(offset)
+            + ", log expects instruction " + to_string(e.instret) + " offset " + to_string(e.arg));
+        return -1;
+    }
+    s.nextInput = s.SeekInput(s.nextInput + 1);
+    return e.value;
+}
+
+void ReplaySession::Port::Write(uint32_t offset, int32_t value, bool word)
+{
+    if (source && !session.replaying)
+        source->Write(offset, value, word);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Devices.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// RECORD / REPLAY OF NONDETERMINISTIC INPUTS
+//
+// Input device reads and interrupt arrivals are the only things that
+// can make two runs of the same program differ (the model checker forks
+// on exactly these). A run can record them, each tagged with the number
+// of instructions retired before it happened. A later run can replay
+// the log, so it repeats the recorded path exactly, with any tracing or
+// timing models attached.
+//
+// Log format, one event per line ('#' starts a comment):
+//   I <instret> <offset> <value>   a read of the input device at base + offset returned value
+//   Q <instret> <line>             an interrupt was taken before instruction <instret> ran
+//                                  (line -1 when no controller raised it, e.g. a checker path)
+//
+// While replaying, the input device is never consulted, and interrupts
+// are delivered only where the log says. They can then arrive at any
+// instruction, not just at block ends, so model checker paths replay
+// as found. The first mismatch (an event at a different instruction,
+// or interrupts disabled when one is due) stops the run and is reported.
+//////////////////////////////////////////////////////////////////////
+
+enum ReplayKind { REPLAY_INPUT, REPLAY_IRQ };
+
+struct ReplayEvent {
+	unsigned long long instret;
+	ReplayKind kind;
+	int32_t arg;    //input: device offset, irq: line
+	int32_t value;  //input: value read
+};
+
+struct ReplayLog {
+	vector<ReplayEvent> events;
+	//False if the file cannot be read or a line is malformed
+	bool Load(const char* fileName);
+	bool Save(const char* fileName) const;
+};
+
+class ReplaySession {
+public:
+	static const unsigned long long NEVER = ~0ULL;
+
+	//replaying = false records into log
+	ReplaySession(ReplayLog& log, bool replaying, const MMIOBus& bus);
+
+	//Device to map in place of `source`: records its reads, or serves them from the log.
+	//source may be null when replaying.
+	MMIODevice* InputPort(MMIODevice* source);
+
+	//Replay: instret of the next logged interrupt
+	unsigned long long NextInterrupt() const { return nextIrq; }
+	//Replay: consumes the interrupt due at instret and returns its line
+	int TakeInterrupt(unsigned long long instret);
+	//Record: an interrupt on line was taken before instruction instret
+	void RecordInterrupt(unsigned long long instret, int line);
+	//Replay: flags events the run never reached
+	void Finish();
+
+	const bool replaying;
+	string divergence; //first mismatch, empty while the run follows the log
+	bool Diverged() const { return !divergence.empty(); }
+	void Diverge(const string& why);
+
+private:
+	class Port : public MMIODevice {
+	public:
+		Port(ReplaySession& session, MMIODevice* source) : session(session), source(source) {}
+		string Name() const override { return source ? source->Name() : "input"; }
+		int32_t Read(uint32_t offset, bool word) override;
+		void Write(uint32_t offset, int32_t value, bool word) override;
+
+	private:
+		ReplaySession& session;
+		MMIODevice* source;
+	};
+
+	ReplayLog& log;
+	const MMIOBus& bus;
+	deque<Port> ports; //stable addresses for the bus
+	size_t nextInput = 0; //replay cursors
+	size_t nextIrqIndex = 0;
+	unsigned long long nextIrq = NEVER;
+
+	void SeekIrq();
+	size_t SeekInput(size_t from) const;
+};
@@ -0,0 +1,424 @@
+#include "SimPoint.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <random>
+
+//////////////////////////////////////////////////////////////////////
+// BASIC BLOCK VECTORS
+//////////////////////////////////////////////////////////////////////
+
+BBVProfiler::BBVProfiler(unsigned long long size)
+    : intervalSize(size ? size : 1)
+{
+}
+
+void BBVProfiler::Retire(unsigned long pc, bool endsBlock)
+{
+    if (newBlock) {
+        blockStart = pc;
+        newBlock = false;
+    }
+    current.blocks[blockStart]++;
+    current.length++;
+    retired++;
+    //A branch ends its block whether it was taken or not
+    if (endsBlock)
+        newBlock = true;
+
+    if (current.length == intervalSize) {
+        intervals.push_back(current);
+        current = Interval();
+        current.start = retired;
+    }
+}
+
+void BBVProfiler::Finish()
+{
+    if (current.length > 0) {
+        intervals.push_back(current);
+        current = Interval();
+        current.start = retired;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// CLUSTERING
+//////////////////////////////////////////////////////////////////////
+
+static const int DIMS = 15; //random projection dimensions, as in SimPoint
+typedef array<double, DIMS> Point;
+
+//Each basic block gets a fixed pseudo random direction, derived from its PC
+static const Point& Direction(unsigned long pc, map<unsigned long, Point>& cache)
+{
+    map<unsigned long, Point>::iterator it = cache.find(pc);
+    if (it == cache.end()) {
+        mt19937 rng((uint32_t)(pc * 2654435761u + 0x9E3779B9u));
+        uniform_real_distribution<double> uni(-1.0, 1.0);
+        Point d;
+        for (double& v : d) {
+            v = uni(rng);
+        }
+        it = cache.insert(make_pair(pc, d)).first;
+    }
+    return it->second;
+}
+
+static double Distance2(const Point& a, const Point& b)
+{
+    double d = 0;
+    for (int i = 0; i < DIMS; i++) {
+        d += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return d;
+}
+
+struct Clustering {
+    int k = 0;
+    vector<Point> centroids;
+    vector<int> assignment;
+    double distortion = numeric_limits<double>::max();
+};
+
+//k-means with k-means++ seeding
+static Clustering KMeans(const vector<Point>& points, int k, mt19937& rng)
+{
+    Clustering c;
+    c.k = k;
+    uniform_int_distribution<size_t> pick(0, points.size() - 1);
+    c.centroids.push_back(points[pick(rng)]);
+    vector<double> nearest(points.size());
+    while ((int)c.centroids.size() < k) {
+        double sum = 0;
+        for (size_t p = 0; p < points.size(); p++) {
+            nearest[p] = numeric_limits<double>::max();
+            for (const Point& ctr : c.centroids) {
+                nearest[p] = min(nearest[p], Distance2(points[p], ctr));
+            }
+            sum += nearest[p];
+        }
+        if (sum == 0) {
+            c.centroids.push_back(points[pick(rng)]);
+            continue;
+        }
+        double r = uniform_real_distribution<double>(0, sum)(rng);
+        size_t chosen = 0;
+        for (; chosen + 1 < points.size(); chosen++) {
+            r -= nearest[chosen];
+            if (r <= 0)
+                break;
+        }
+        c.centroids.push_back(points[chosen]);
+    }
+
+    c.assignment.assign(points.size(), -1);
+    for (int iter = 0; iter < 100; iter++) {
+        bool changed = false;
+        for (size_t p = 0; p < points.size(); p++) {
+            int best = 0;
+            for (int j = 1; j < k; j++) {
+                if (Distance2(points[p], c.centroids[j]) < Distance2(points[p], c.centroids[best]))
+                    best = j;
+            }
+            if (best != c.assignment[p]) {
+                c.assignment[p] = best;
+                changed = true;
+            }
+        }
+        if (!changed)
+            break;
+        vector<Point> sums(k, Point());
+        vector<int> counts(k, 0);
+        for (size_t p = 0; p < points.size(); p++) {
+            for (int i = 0; i < DIMS; i++) {
+                sums[c.assignment[p]][i] += points[p][i];
+            }
+            counts[c.assignment[p]]++;
+        }
+        for (int j = 0; j < k; j++) {
+            if (counts[j] == 0)
+                continue; //empty cluster keeps its old centroid
+            for (int i = 0; i < DIMS; i++) {
+                c.centroids[j][i] = sums[j][i] / counts[j];
+            }
+        }
+    }
+
+    c.distortion = 0;
+    for (size_t p = 0; p < points.size(); p++) {
+        c.distortion += Distance2(points[p], c.centroids[c.assignment[p]]);
+    }
+    return c;
+}
+
+//Bayesian information criterion of a spherical Gaussian mixture (Pelleg & Moore)
+static double BIC(const vector<Point>& points, const Clustering& c)
+{
+    double R = (double)points.size();
+    int k = c.k;
+    if (R <= k)
+        return -numeric_limits<double>::max();
+    double variance = max(c.distortion / (R - k), 1e-12);
+    vector<int> sizes(k, 0);
+    for (int a : c.assignment) {
+        sizes[a]++;
+    }
+    double logLikelihood = 0;
+    for (int j = 0; j < k; j++) {
+        double Rn = sizes[j];
+        if (Rn == 0)
+            continue;
+        logLikelihood += -Rn / 2 * log(2 * M_PI) - Rn * DIMS / 2 * log(variance) - (Rn - k) / 2
+            + Rn * log(Rn) - Rn * log(R);
+    }
+    double params = k * (DIMS + 1);
+    return logLikelihood - params / 2 * log(R);
+}
+
+//////////////////////////////////////////////////////////////////////
+// DETAILED SIMULATION
+//////////////////////////////////////////////////////////////////////
+
+struct DetailedResult {
+    unsigned long long instructions = 0;
+    unsigned long long cycles = 0;
+    double CPI() const { return instructions ? (double)cycles / instructions : 0; }
+};
+
+//Runs `length` instructions from `start` with the timing model attached. The first
+//`warmup` instructions train the caches and predictor but are not counted.
+static DetailedResult RunDetailed(unsigned char instMem[], int maxPC, const SimPointConfig& config,
+    const Checkpoint& start, unsigned long long warmup, unsigned long long length)
+{
+    CacheSim caches;
+    CacheConfig cacheConfig;
+    CacheConfig::Parse(config.cacheSpec, cacheConfig);
+    caches.AddConfig(cacheConfig);
+    BranchModel branches;
+    branches.AddPredictor(BranchPredictor::Create(config.predictorSpec));
+
+    SimOptions options;
+    options.caches = &caches;
+    options.branches = &branches;
+    int registers[32];
+    Checkpoint warm = start;
+    if (warmup > 0) {
+        options.start = &start;
+        options.end = &warm;
+        options.maxInstructions = warmup;
+        RunProgram(instMem, maxPC, options, registers);
+        caches.ResetStats();
+        branches.ResetStats();
+    }
+
+    options.start = &warm;
+    options.end = nullptr;
+    options.maxInstructions = length;
+    DetailedResult r;
+    r.instructions = RunProgram(instMem, maxPC, options, registers);
+    r.cycles = r.instructions + config.missPenalty * caches.Misses(0) + config.mispredictPenalty * branches.Mispredicts(0);
+    return r;
+}
+
+//////////////////////////////////////////////////////////////////////
+// DRIVER
+//////////////////////////////////////////////////////////////////////
+
+unsigned long long RunSimPoint(unsigned char instMem[], int maxPC, const SimPointConfig& config, int registers[], ostream& report)
+{
+    //1. PROFILE
+    BBVProfiler profiler(config.intervalSize);
+    SimOptions profileOptions;
+    profileOptions.detectLoops = config.detectLoops;
+    profileOptions.bbv = &profiler;
+    unsigned long long total = RunProgram(instMem, maxPC, profileOptions, registers);
+    profiler.Finish();
+    const vector<BBVProfiler::Interval>& intervals = profiler.intervals;
+    if (intervals.empty()) {
+        report << "[SIMPOINT] program retired no instructions" << endl;
+        return total;
+    }
+
+    //2. CLUSTER
+    map<unsigned long, Point> directions;
+    vector<Point> points;
+    for (const BBVProfiler::Interval& in : intervals) {
+        Point p = Point();
+        for (const pair<const unsigned long, unsigned long long>& b : in.blocks) {
+            const Point& d = Direction(b.first, directions);
+            double share = (double)b.second / in.length;
+            for (int i = 0; i < DIMS; i++) {
+                p[i] += share * d[i];
+            }
+        }
+        points.push_back(p);
+    }
+
+    mt19937 rng(12345);
+    int maxK = max(1, min(config.maxK, (int)points.size()));
+    vector<Clustering> candidates;
+    vector<double> scores;
+    for (int k = 1; k <= maxK; k++) {
+        Clustering best;
+        for (int restart = 0; restart < 5; restart++) {
+            Clustering c = KMeans(points, k, rng);
+            if (c.distortion < best.distortion)
+                best = c;
+        }
+        candidates.push_back(best);
+        scores.push_back(BIC(points, best));
+    }
+    double lo = *min_element(scores.begin(), scores.end());
+    double hi = *max_element(scores.begin(), scores.end());
+    size_t chosen = 0;
+    while (chosen + 1 < scores.size() && scores[chosen] < lo + 0.9 * (hi - lo)) {
+        chosen++;
+    }
+    const Clustering& clusters = candidates[chosen];
+
+    //3. SAMPLE: closest to the centroid first, then random members
+    int k = clusters.k;
+    vector<vector<size_t>> members(k);
+    for (size_t p = 0; p < points.size(); p++) {
+        members[clusters.assignment[p]].push_back(p);
+    }
+    vector<vector<size_t>> samples(k);
+    for (int j = 0; j < k; j++) {
+        if (members[j].empty())
+            continue;
+        vector<size_t> pool = members[j];
+        size_t rep = 0;
+        for (size_t m = 1; m < pool.size(); m++) {
+            if (Distance2(points[pool[m]], clusters.centroids[j]) < Distance2(points[pool[rep]], clusters.centroids[j]))
+                rep = m;
+        }
+        samples[j].push_back(pool[rep]);
+        pool.erase(pool.begin() + rep);
+        shuffle(pool.begin(), pool.end(), rng);
+        for (size_t m = 0; m < pool.size() && (int)samples[j].size() < config.samplesPerCluster; m++) {
+            samples[j].push_back(pool[m]);
+        }
+    }
+
+    //4. FAST-FORWARD to every sample start (less warm-up) and save checkpoints
+    map<unsigned long long, Checkpoint> checkpoints;
+    for (int j = 0; j < k; j++) {
+        for (size_t s : samples[j]) {
+            unsigned long long at = intervals[s].start;
+            checkpoints[at - min(at, config.warmup)] = Checkpoint();
+        }
+    }
+    Checkpoint state;
+    for (map<unsigned long long, Checkpoint>::iterator it = checkpoints.begin(); it != checkpoints.end(); ++it) {
+        if (it->first > state.instret) {
+            SimOptions ff;
+            ff.start = &state;
+            ff.end = &state;
+            ff.maxInstructions = it->first - state.instret;
+            int ffRegisters[32];
+            RunProgram(instMem, maxPC, ff, ffRegisters);
+        }
+        it->second = state;
+    }
+
+    //5. DETAILED RUNS and stratified estimate
+    report << fixed << setprecision(4);
+    report << "[SIMPOINT] " << intervals.size() << " intervals of " << config.intervalSize << " instructions, "
+        << k << " clusters (BIC over k = 1.." << maxK << ")" << endl;
+    double estimate = 0, variance = 0;
+    double pooledRelVar = 0;
+    int pooledCount = 0;
+    vector<double> clusterCPI(k, 0), clusterWeight(k, 0), clusterVar(k, -1);
+    unsigned long long detailedInstructions = 0;
+    for (int j = 0; j < k; j++) {
+        if (members[j].empty())
+            continue;
+        unsigned long long clusterInstructions = 0;
+        for (size_t m : members[j]) {
+            clusterInstructions += intervals[m].length;
+        }
+        clusterWeight[j] = (double)clusterInstructions / total;
+
+        vector<double> cpis;
+        for (size_t s : samples[j]) {
+            unsigned long long at = intervals[s].start;
+            unsigned long long warm = min(at, config.warmup);
+            DetailedResult r = RunDetailed(instMem, maxPC, config, checkpoints[at - warm], warm, intervals[s].length);
+            cpis.push_back(r.CPI());
+            detailedInstructions += warm + r.instructions;
+        }
+        double mean = 0;
+        for (double c : cpis) {
+            mean += c;
+        }
+        mean /= cpis.size();
+        clusterCPI[j] = mean;
+        estimate += clusterWeight[j] * mean;
+
+        double n = (double)members[j].size(), m = (double)cpis.size();
+        if (m == n) {
+            clusterVar[j] = 0; //every interval was simulated
+        }
+        else if (m >= 2) {
+            double s2 = 0;
+            for (double c : cpis) {
+                s2 += (c - mean) * (c - mean);
+            }
+            s2 /= m - 1;
+            clusterVar[j] = s2 / m * (1 - m / n);
+            if (mean > 0) {
+                pooledRelVar += s2 / (mean * mean);
+                pooledCount++;
+            }
+        }
+        report << "  cluster " << j << ": weight " << clusterWeight[j] << ", " << members[j].size() << " intervals, sampled";
+        for (size_t s : samples[j]) {
+            report << " #" << s;
+        }
+        report << ", CPI " << mean << endl;
+    }
+
+    //Clusters with a single sample borrow the spread seen in the others
+    bool bounded = true;
+    for (int j = 0; j < k; j++) {
+        if (members[j].empty())
+            continue;
+        if (clusterVar[j] < 0) {
+            if (pooledCount == 0) {
+                bounded = false;
+                continue;
+            }
+            double n = (double)members[j].size();
+            clusterVar[j] = pooledRelVar / pooledCount * clusterCPI[j] * clusterCPI[j] * (1 - 1 / n);
+        }
+        variance += clusterWeight[j] * clusterWeight[j] * clusterVar[j];
+    }
+
+    report << "[SIMPOINT] estimated CPI " << estimate;
+    if (bounded) {
+        double bound = 1.96 * sqrt(variance);
+        report << " +/- " << bound << " (95%, " << (estimate > 0 ? 100 * bound / estimate : 0)
+            << " %, sampling error only: excludes cold-start bias";
+        if (config.warmup > 0)
+            report << " left after the " << config.warmup << "-instruction warm-up)";
+        else
+            report << ", and there was no warm-up)";
+    }
+    else {
+        report << " (no error bound: every cluster has a single sample, use --sp-samples 2 or more)";
+    }
+    report << ", detailed simulation of " << detailedInstructions << " of " << total << " instructions" << endl;
+
+    if (config.compareFull) {
+        DetailedResult full = RunDetailed(instMem, maxPC, config, Checkpoint(), 0, 0);
+        report << "[SIMPOINT] full detailed CPI " << full.CPI() << ", estimate error "
+            << (full.CPI() > 0 ? 100 * (estimate - full.CPI()) / full.CPI() : 0) << " %" << endl;
+    }
+    report.unsetf(ios::floatfield);
+    report << setprecision(6);
+    return total;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Simulator.h"
+#include <map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// SIMPOINT STYLE SAMPLED SIMULATION
+//
+// 1. Profile: run the whole program functionally and cut it into
+//    fixed-size intervals. For each interval, record a basic block
+//    vector: how many instructions ran in each basic block.
+// 2. Cluster: project the normalised vectors to a few random dimensions,
+//    run k-means for k = 1..maxK, and keep the smallest k whose BIC
+//    score is within 90% of the best.
+// 3. Sample: from each cluster take the interval closest to the centroid,
+//    plus a few random members so the spread can be estimated.
+// 4. Fast-forward functionally to each sample (less warm-up), save a
+//    checkpoint, and run only that interval with the cache and branch
+//    predictor timing model attached.
+// 5. Weight each cluster's CPI by its share of the instructions. The
+//    error bound comes from the stratified sampling variance only. It
+//    does not cover cold-start bias from caches and predictors that were
+//    not warm when a sample began.
+//
+// Timing model: CPI = 1 + missPenalty * L1 misses / inst
+//                       + mispredictPenalty * mispredictions / inst
+//////////////////////////////////////////////////////////////////////
+
+class BBVProfiler {
+public:
+	struct Interval {
+		unsigned long long start = 0;  //first instruction (retired count)
+		unsigned long long length = 0;
+		map<unsigned long, unsigned long long> blocks; //block start PC -> instructions executed
+	};
+
+	explicit BBVProfiler(unsigned long long intervalSize);
+	//Called for every retired instruction. endsBlock: it was a branch or jump.
+	void Retire(unsigned long pc, bool endsBlock);
+	//Closes the last, partial interval
+	void Finish();
+
+	vector<Interval> intervals;
+
+private:
+	unsigned long long intervalSize;
+	unsigned long long retired = 0;
+	unsigned long blockStart = 0;
+	bool newBlock = true;
+	Interval current;
+};
+
+struct SimPointConfig {
+	unsigned long long intervalSize = 10000;
+	int maxK = 10;
+	int samplesPerCluster = 2;      //>= 2 lets the error bound use each cluster's own spread
+	unsigned long long warmup = 0;  //instructions run before each sample to warm caches and predictors
+	string cacheSpec = "4096:2:32:lru";
+	string predictorSpec = "gshare";
+	unsigned missPenalty = 10;
+	unsigned mispredictPenalty = 3;
+	bool compareFull = false;       //also run the whole program in detailed mode and print the true CPI
+	bool detectLoops = false;
+};
+
+//Profiles, clusters and samples the program, printing the report to `report`.
+//registers receives the final register file of the functional run. Returns instructions retired.
+unsigned long long RunSimPoint(unsigned char instMem[], int maxPC, const SimPointConfig& config, int registers[], ostream& report);
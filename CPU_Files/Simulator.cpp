@@ -0,0 +1,313 @@
+#include "Simulator.h"
+#include "IdleLoop.h"
+#include "Events.h"
+#include "Replay.h"
+#include "CycleDetector.h"
+#include "SimPoint.h"
+#include "Wcet.h"
+#include "Devices.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+int LoadProgram(const char* fileName, unsigned char instMem[])
+{
+	ifstream infile(fileName); //open the file
+	if (!(infile.is_open() && infile.good())) {
+		return -1;
+	}
+
+	string line;
+	int i = 0;
+	
+	// Read each line in the input file, assuming each line represents 1 byte in hexadecimal
+	while (std::getline(infile, line) && i < 4096) {
+		std::stringstream line2(line);
+		int hexValue;
+
+		// Convert each hex line to an integer, then cast it to char and store in instMem
+		line2 >> std::hex >> hexValue;
+		instMem[i] = static_cast<char>(hexValue);
+
+		i++;
+	}
+	return i;
+}
+
+//Guest time of the next thing that can interrupt the program (NEVER if nothing can)
+static unsigned long long NextWake(const SimOptions& options)
+{
+	if (options.replay && options.replay->replaying)
+		return options.replay->NextInterrupt();
+	return options.events ? options.events->nextDue : TimerWheel::NEVER;
+}
+
+unsigned long long RunProgram(unsigned char instMem[], int maxPC, const SimOptions& options, int registers[])
+{
+	/* Instantiate your CPU object here.  CPU class is the main class in this project that defines different components of the processor.
+	CPU class also has different functions for each stage (e.g., fetching an instruction, decoding, etc.).
+	*/
+
+	CPU myCPU;  // call the approriate constructor here to initialize the processor...  
+	// make sure to create a variable for PC and resets it to zero (e.g., unsigned int PC = 0); 
+
+	//REGISTERS and their values (All set to zero to start)
+	const int NUM_REGISTERS = 32;
+	for (int r = 0; r < NUM_REGISTERS; r++) {
+		registers[r] = options.start ? options.start->registers[r] : 0;
+	}
+	if (options.start) {
+		myCPU.incPC(options.start->pc);
+		myCPU.RestoreMemory(options.start->dmemory.data());
+	}
+	myCPU.AttachBus(options.bus);
+	//Guest time continues from the checkpoint
+	unsigned long long startInstret = options.start ? options.start->instret : 0;
+
+
+
+	//Predecoded blocks for spotting loops that can never change state
+	IdleLoopDetector idleLoops;
+	CycleDetector cycles;
+	unsigned long long instret = 0;
+	bool branchTaken = false;
+
+	bool done = true;
+	while (done == true) // processor's main loop. Each iteration is equal to one clock cycle.  
+	{
+		///////////////
+		//// FETCH ////
+		///////////////
+
+		//Only make an instruction if its 32 more bits
+		if (maxPC - myCPU.readPC() < 4)
+			break;
+		if (options.maxInstructions && instret >= options.maxInstructions)
+			break;
+
+		//A replayed interrupt arrives before the logged instruction, wherever it is
+		if (options.replay && options.replay->replaying) {
+			unsigned long long now = startInstret + instret;
+			if (now == options.replay->NextInterrupt()) {
+				if (options.events && now >= options.events->nextDue)
+					options.events->Advance(now);
+				if (registers[InterruptController::MSTATUS_REG] & 1) {
+					options.replay->TakeInterrupt(now);
+					registers[InterruptController::EPC_REG] = myCPU.readPC();
+					registers[InterruptController::MSTATUS_REG] &= ~1;
+					myCPU.incPC(InterruptController::HANDLER_ADDR);
+					if (options.events)
+						options.events->interruptsTaken++;
+				}
+				else {
+					options.replay->Diverge("interrupt logged at instruction " + to_string(now) + " arrives with interrupts disabled");
+				}
+			}
+			if (options.replay->Diverged())
+				break;
+		}
+
+		 // --- DEBUG: Print all register values after this instruction ---
+    	/*cout << "PC: " << myCPU.readPC() << " | Registers: ";
+    	for (int r = 0; r < NUM_REGISTERS; r++) {
+        	cout << "x" << r << "=" << registers[r] << " ";
+    	}
+    	cout << endl;*/
+		
+		/* Instantiate your Instruction object here. */
+		Instruction myInst(instMem, myCPU); 
+		if (options.caches)
+			options.caches->Access(ACCESS_FETCH, myCPU.readPC(), myCPU.readPC());
+		if (options.memTrace)
+			WriteTraceRecord(*options.memTrace, ACCESS_FETCH, myCPU.readPC(), myCPU.readPC());
+
+		//Getting the next PC without jumps
+		unsigned long nextPC = myCPU.readPC() + 4;
+
+		////////////////
+		//// DECODE	////
+		////////////////
+		Controller myController(myInst);
+		ALU_Controller myALU_Control(myInst, myController.ALUOp);
+		int32_t ImmValue = ImmGen(myInst);
+
+		//Register Address 
+		int rd =  (myInst.instr[11] << 4) | (myInst.instr[10] << 3) | (myInst.instr[9] << 2)  |	(myInst.instr[8] << 1)  | (myInst.instr[7]);	
+		int rs1 = (myInst.instr[19] << 4) | (myInst.instr[18] << 3) | (myInst.instr[17] << 2) | (myInst.instr[16] << 1) | (myInst.instr[15]);
+		int rs2 = (myInst.instr[24] << 4) | (myInst.instr[23] << 3) | (myInst.instr[22] << 2) | (myInst.instr[21] << 1) | (myInst.instr[20]);
+
+
+		////////////////
+		// EXECUTION  //
+		////////////////
+
+		//Keeping x0 at 0
+		registers[0] = 0;
+		
+		//Read Registers
+		int rs1Val = registers[rs1];
+		int rs2Val = registers[rs2];
+
+		//KEEP THIS IN CASE OF WRITE DATAPATH
+		int prevRS2 = rs2Val;
+
+		//MUX1 Between RS2 and Imm Gen going into ALU
+		rs2Val = myController.AluSrc ? ImmValue : rs2Val;
+
+		//ALU Operation
+		int32_t ALU_Res = ALU_Result(rs1Val, rs2Val, myALU_Control.ALUOp);
+		bool zeroFlag = ALU_Res ? 0 : 1;
+		
+		//Check on Branch Condition (Changes the next PC to jump)
+		branchTaken = (myController.Branch == zeroFlag) && (zeroFlag == 1);
+		if (options.branches && myController.Branch) {
+			uint32_t target = myCPU.readPC() + ImmValue;
+			if (myController.opcode == bitset<7>(0b1101111))
+				options.branches->Jump(myCPU.readPC(), target, rd != 0);
+			else
+				options.branches->Conditional(myCPU.readPC(), target, branchTaken);
+		}
+		if (branchTaken) {
+			nextPC = myCPU.readPC() + ImmValue; //Only multiplied by 4 to compensate
+
+			//Backward jump into a block that cannot change state: the guest spins forever
+			if (nextPC <= myCPU.readPC() && idleLoops.IsIdleLoop(instMem, maxPC, nextPC, myCPU.readPC(), registers)) {
+				//With interrupts enabled the next event can break the loop: skip whole iterations up to it
+				unsigned long long wake = NextWake(options);
+				if ((registers[InterruptController::MSTATUS_REG] & 1) && wake != TimerWheel::NEVER) {
+					//Whole iterations only, so the loop resumes at its head right before the event
+					unsigned long long period = (myCPU.readPC() - nextPC) / 4 + 1;
+					unsigned long long now = startInstret + instret + 1;
+					unsigned long long skip = wake > now ? (wake - now) / period * period : 0;
+					if (options.maxInstructions && instret + skip > options.maxInstructions)
+						skip = (options.maxInstructions - instret) / period * period;
+					instret += skip;
+				}
+				else {
+					cerr << "[IDLE] Non-terminating idle loop at PC " << nextPC << "-" << myCPU.readPC() << ", stopping" << endl;
+					break;
+				}
+			}
+		}
+
+		/////////////////
+		//MEMORY ACCESS//
+		/////////////////
+
+		//If the LOAD/Store
+		bool isWord = false;
+
+		//If we write from memory (LOAD)
+		if (myController.opcode == bitset<7>(0b0000011)) {
+			//LOAD WORD
+			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0x2000)) {
+				isWord = true;
+			}
+			//LOAD BYTE
+			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0b0)) {
+				isWord = false;
+			}
+		}
+		//If we write to memory (STORE)
+		else if (myController.opcode == bitset<7>(0b0100011)) {
+			//STORE WORD (32 bits)
+			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0x2000)) {
+				isWord = true;
+			}
+			//STORE BYTE
+			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0b0)) {
+				isWord = false;
+			}
+		}
+
+		if (myController.MemWr || myController.MemRe) {
+			AccessType type = myController.MemWr ? ACCESS_STORE : ACCESS_LOAD;
+			if (options.caches)
+				options.caches->Access(type, myCPU.readPC(), (uint32_t)ALU_Res);
+			if (options.memTrace)
+				WriteTraceRecord(*options.memTrace, type, myCPU.readPC(), (uint32_t)ALU_Res);
+		}
+
+		if (options.bus)
+			options.bus->now = startInstret + instret;
+
+		// DATA MEMORY OUTPUT
+		int32_t Read_Data = myCPU.DataMemory(myController.MemWr, myController.MemRe, ALU_Res, prevRS2, isWord);
+		if (options.events && myController.MemWr && options.events->irq.TakeReturn()) {
+			nextPC = registers[InterruptController::EPC_REG];
+			registers[InterruptController::MSTATUS_REG] |= 1;
+		}
+
+		//////////////
+		//WRITE BACK//
+		//////////////
+		if (myController.regWrite) {
+			//ADD A condition to Write the next PC if its a JAL
+			if (myController.opcode == bitset<7>(0b1101111)) {
+				registers[rd] = myCPU.readPC() + 4;
+			}
+			else {
+				registers[rd] = myController.MemtoReg ? Read_Data : ALU_Res;
+			}
+		}
+		if (options.execTrace) {
+			*options.execTrace << startInstret + instret << " " << hex << myCPU.readPC() << " " << setw(8) << setfill('0') << myInst.instr.to_ulong() << setfill(' ') << dec;
+			if (myController.regWrite && rd != 0)
+				*options.execTrace << " x" << rd << "=" << registers[rd];
+			*options.execTrace << "\n";
+		}
+
+
+		if (options.bbv)
+			options.bbv->Retire(myCPU.readPC(), myController.Branch);
+		if (options.cycleCount)
+			options.cycleCount->Retire(myController, branchTaken);
+
+		//Update PC 
+		myCPU.incPC(nextPC);
+		instret++;
+
+		//Events and interrupts are only looked at when a block ends
+		if (options.events && myController.Branch) {
+			if (startInstret + instret >= options.events->nextDue)
+				options.events->Advance(startInstret + instret);
+			bool replaying = options.replay && options.replay->replaying;
+			if (!replaying && options.events->irq.Deliverable() && (registers[InterruptController::MSTATUS_REG] & 1)) {
+				if (options.replay)
+					options.replay->RecordInterrupt(startInstret + instret, options.events->irq.HighestPending());
+				registers[InterruptController::EPC_REG] = myCPU.readPC();
+				registers[InterruptController::MSTATUS_REG] &= ~1;
+				myCPU.incPC(InterruptController::HANDLER_ADDR);
+				options.events->interruptsTaken++;
+			}
+		}
+
+		//Any repeating state has to pass a taken branch, so only sample there
+		//(not while an event can still break a spin with interrupts enabled)
+		bool eventsAhead = (registers[InterruptController::MSTATUS_REG] & 1) && NextWake(options) != TimerWheel::NEVER;
+		if (options.detectLoops && branchTaken && !eventsAhead) {
+			registers[0] = 0;
+			if (cycles.Observe(myCPU.readPC(), registers, myCPU.writeEpoch, instret)) {
+				cerr << "[LOOP] Non-termination detected: loop entry PC " << cycles.loopPC << ", period " << cycles.period << " instructions" << endl;
+				break;
+			}
+		}
+		if (myCPU.readPC() > maxPC)
+			break;
+	}
+
+	if (options.replay)
+		options.replay->Finish();
+	if (options.end) {
+		registers[0] = 0;
+		options.end->pc = myCPU.readPC();
+		for (int r = 0; r < NUM_REGISTERS; r++) {
+			options.end->registers[r] = registers[r];
+		}
+		options.end->dmemory.resize(4096);
+		myCPU.SaveMemory(options.end->dmemory.data());
+		options.end->instret = startInstret + instret;
+	}
+	return instret;
+}
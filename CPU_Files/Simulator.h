@@ -0,0 +1,47 @@
+#pragma once
+#include "CPU.h"
+#include "CacheSim.h"
+#include "BranchPredictor.h"
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// SINGLE HART RUN LOOP
+// Shared by cpusim and the benchmark driver.
+//////////////////////////////////////////////////////////////////////
+
+class BBVProfiler;
+class CycleCounter;
+class MMIOBus;
+class EventScheduler;
+class ReplaySession;
+
+//Architectural state at an instruction boundary, enough to resume a run
+struct Checkpoint {
+	unsigned long pc = 0;
+	int registers[32] = {};
+	vector<int> dmemory = vector<int>(4096, 0);
+	unsigned long long instret = 0; //instructions retired before this point
+};
+
+struct SimOptions {
+	bool detectLoops = false; //Brent cycle detection (see CycleDetector.h)
+	CacheSim* caches = nullptr; //fed every fetch, load and store when set (see CacheSim.h)
+	ostream* memTrace = nullptr; //records every fetch, load and store for offline cache runs
+	BranchModel* branches = nullptr; //fed every BEQ and JAL when set (see BranchPredictor.h)
+	BBVProfiler* bbv = nullptr; //basic block vectors per interval (see SimPoint.h)
+	const Checkpoint* start = nullptr; //resume from here instead of a reset CPU
+	Checkpoint* end = nullptr; //receives the state the run stopped in
+	unsigned long long maxInstructions = 0; //stop after this many instructions (0 = run to completion)
+	CycleCounter* cycleCount = nullptr; //charges every instruction its latency (see Wcet.h)
+	MMIOBus* bus = nullptr; //devices mapped past the end of RAM (see Devices.h)
+	EventScheduler* events = nullptr; //timed events and interrupts, checked at block boundaries (see Events.h)
+	ReplaySession* replay = nullptr; //records interrupts, or replays them from a log (see Replay.h)
+	ostream* execTrace = nullptr; //one line per retired instruction: instret, PC, encoding, register written
+};
+
+//Load a trace file (one hex byte per line) into instMem. Returns the number of bytes read, or -1 if the file cannot be opened.
+int LoadProgram(const char* fileName, unsigned char instMem[]);
+
+//Run the program until the PC leaves it (or a non-terminating loop is found, maxInstructions retire, or a replay diverges).
+//registers must hold 32 entries and receive the final register file. Returns instructions retired.
+unsigned long long RunProgram(unsigned char instMem[], int maxPC, const SimOptions& options, int registers[]);
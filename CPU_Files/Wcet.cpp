@@ -0,0 +1,694 @@
+#include "Wcet.h"
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <sstream>
+
+static const char* OP_NAMES[NUM_OP_CLASSES] = { "r", "i", "lui", "load", "store", "beq", "jal", "other" };
+
+bool LatencyTable::Load(const char* fileName)
+{
+    ifstream in(fileName);
+    if (!in)
+        return false;
+    string line;
+    while (getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        stringstream ss(line);
+        string name;
+        unsigned value;
+        if (!(ss >> name))
+            continue;
+        if (!(ss >> value))
+            return false;
+        if (name == "taken") {
+            takenPenalty = value;
+            continue;
+        }
+        int c = 0;
+        while (c < NUM_OP_CLASSES && name != OP_NAMES[c]) {
+            c++;
+        }
+        if (c == NUM_OP_CLASSES)
+            return false;
+        cycles[c] = value;
+    }
+    return true;
+}
+
+OpClass LatencyTable::Classify(const Controller& ctrl)
+{
+    switch (ctrl.opcode.to_ulong()) {
+    case 0b0110011: return OP_R;
+    case 0b0010011: return OP_I;
+    case 0b0110111: return OP_LUI;
+    case 0b0000011: return OP_LOAD;
+    case 0b0100011: return OP_STORE;
+    case 0b1100011: return OP_BEQ;
+    case 0b1101111: return OP_JAL;
+    default: return OP_OTHER;
+    }
+}
+
+void CycleCounter::Retire(const Controller& ctrl, bool taken)
+{
+    OpClass kind = LatencyTable::Classify(ctrl);
+    cycles += table.cycles[kind];
+    if (kind == OP_BEQ && taken)
+        cycles += table.takenPenalty;
+}
+
+//a * b, stuck at ULLONG_MAX instead of wrapping
+static unsigned long long SatMul(unsigned long long a, unsigned long long b)
+{
+    if (a != 0 && b > ULLONG_MAX / a)
+        return ULLONG_MAX;
+    return a * b;
+}
+
+static unsigned long long SatAdd(unsigned long long a, unsigned long long b)
+{
+    return a > ULLONG_MAX - b ? ULLONG_MAX : a + b;
+}
+
+static string Hex(unsigned long v)
+{
+    stringstream ss;
+    ss << "0x" << hex << v;
+    return ss.str();
+}
+
+WcetAnalyzer::WcetAnalyzer(unsigned char mem[], int max, const LatencyTable& t)
+    : instMem(mem), maxPC(max), table(t)
+{
+}
+
+//////////////////////////////////////////////////////////////////////
+// CFG
+//////////////////////////////////////////////////////////////////////
+
+void WcetAnalyzer::BuildCFG()
+{
+    //RunProgram stops once fewer than 4 bytes are left at the PC
+    unsigned long end = maxPC >= 4 ? (unsigned long)maxPC - 3 : 0; //first PC that leaves the program
+    map<unsigned long, Inst> decoded;
+    set<unsigned long> leaders;
+    if (end > 0)
+        leaders.insert(0);
+    for (unsigned long pc = 0; pc < end; pc += 4) {
+        Instruction inst(instMem, pc);
+        Controller ctrl(inst);
+        ALU_Controller alu(inst, ctrl.ALUOp);
+        unsigned long word = inst.instr.to_ulong();
+        Inst in;
+        in.pc = pc;
+        in.kind = LatencyTable::Classify(ctrl);
+        in.rd = (word >> 7) & 0x1F;
+        in.rs1 = (word >> 15) & 0x1F;
+        in.rs2 = (word >> 20) & 0x1F;
+        in.imm = ImmGen(inst);
+        in.regWrite = ctrl.regWrite;
+        in.aluSrc = ctrl.AluSrc;
+        in.aluOp = alu.ALUOp;
+        decoded[pc] = in;
+
+        if (in.kind == OP_BEQ || in.kind == OP_JAL) {
+            unsigned long target = pc + in.imm;
+            if (target < end && target % 4)
+                problems.push_back("unaligned branch target " + Hex(target) + " at " + Hex(pc));
+            else if (target < end)
+                leaders.insert(target);
+            if (pc + 4 < end)
+                leaders.insert(pc + 4);
+        }
+    }
+
+    map<unsigned long, int> blockAt;
+    for (unsigned long leader : leaders) {
+        blockAt[leader] = (int)blocks.size();
+        Block b;
+        b.start = leader;
+        blocks.push_back(b);
+    }
+    for (size_t b = 0; b < blocks.size(); b++) {
+        unsigned long pc = blocks[b].start;
+        do {
+            blocks[b].insts.push_back(decoded[pc]);
+            blocks[b].cost += table.cycles[decoded[pc].kind];
+            pc += 4;
+        } while (pc < end && !leaders.count(pc)
+            && blocks[b].insts.back().kind != OP_BEQ && blocks[b].insts.back().kind != OP_JAL);
+
+        const Inst& last = blocks[b].insts.back();
+        unsigned long fall = last.pc + 4;
+        unsigned long target = last.pc + last.imm;
+        if (last.kind == OP_BEQ || last.kind == OP_JAL) {
+            blocks[b].succs.push_back(target < end && blockAt.count(target) ? blockAt[target] : -1);
+            blocks[b].takenEdge.push_back(last.kind == OP_BEQ);
+        }
+        if (last.kind != OP_JAL) {
+            blocks[b].succs.push_back(fall < end && blockAt.count(fall) ? blockAt[fall] : -1);
+            blocks[b].takenEdge.push_back(false);
+        }
+    }
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (int s : blocks[b].succs) {
+            if (s >= 0)
+                blocks[s].preds.push_back((int)b);
+        }
+    }
+}
+
+void WcetAnalyzer::ComputeDominators()
+{
+    int n = (int)blocks.size();
+    set<int> all;
+    for (int b = 0; b < n; b++) {
+        all.insert(b);
+    }
+    dominators.assign(n, all);
+    if (n == 0)
+        return;
+    dominators[0] = { 0 };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = 1; b < n; b++) {
+            set<int> dom = all;
+            bool anyPred = false;
+            for (int p : blocks[b].preds) {
+                set<int> meet;
+                set_intersection(dom.begin(), dom.end(), dominators[p].begin(), dominators[p].end(), inserter(meet, meet.begin()));
+                dom.swap(meet);
+                anyPred = true;
+            }
+            if (!anyPred)
+                dom.clear();
+            dom.insert(b);
+            if (dom != dominators[b]) {
+                dominators[b] = dom;
+                changed = true;
+            }
+        }
+    }
+}
+
+void WcetAnalyzer::FindLoops()
+{
+    //Natural loop of every back edge u -> h (h dominates u); loops sharing a header merge
+    map<int, int> loopAt;
+    for (size_t u = 0; u < blocks.size(); u++) {
+        if (!blockVisited[u])
+            continue;
+        for (int h : blocks[u].succs) {
+            if (h < 0 || !dominators[u].count(h))
+                continue;
+            if (!loopAt.count(h)) {
+                loopAt[h] = (int)loops.size();
+                Loop l;
+                l.header = h;
+                l.blocks.insert(h);
+                loops.push_back(l);
+            }
+            Loop& loop = loops[loopAt[h]];
+            vector<int> work;
+            if (loop.blocks.insert((int)u).second)
+                work.push_back((int)u);
+            while (!work.empty()) {
+                int x = work.back();
+                work.pop_back();
+                for (int p : blocks[x].preds) {
+                    if (blockVisited[p] && loop.blocks.insert(p).second)
+                        work.push_back(p);
+                }
+            }
+        }
+    }
+
+    //Nesting: the parent is the smallest other loop containing the header
+    for (size_t l = 0; l < loops.size(); l++) {
+        for (size_t o = 0; o < loops.size(); o++) {
+            if (o == l || !loops[o].blocks.count(loops[l].header) || loops[o].blocks.size() <= loops[l].blocks.size())
+                continue;
+            if (loops[l].parent < 0 || loops[o].blocks.size() < loops[loops[l].parent].blocks.size())
+                loops[l].parent = (int)o;
+        }
+    }
+    innermost.assign(blocks.size(), -1);
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (size_t l = 0; l < loops.size(); l++) {
+            if (loops[l].blocks.count((int)b) && (innermost[b] < 0 || loops[l].blocks.size() < loops[innermost[b]].blocks.size()))
+                innermost[b] = (int)l;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// CONSTANTS AND LOOP BOUNDS
+//////////////////////////////////////////////////////////////////////
+
+void WcetAnalyzer::PropagateConstants()
+{
+    RegState reset;
+    for (int r = 0; r < 32; r++) {
+        reset.known[r] = true; //RunProgram starts from an all-zero register file
+        reset.value[r] = 0;
+    }
+    blockOut.assign(blocks.size(), reset);
+    blockVisited.assign(blocks.size(), false);
+    if (blocks.empty())
+        return;
+
+    vector<int> work = { 0 };
+    vector<bool> queued(blocks.size(), false);
+    queued[0] = true;
+    while (!work.empty()) {
+        int b = work.back();
+        work.pop_back();
+        queued[b] = false;
+
+        //Meet over the predecessors already reached (plus the reset state at the entry)
+        RegState state = reset;
+        bool first = b != 0;
+        for (int p : blocks[b].preds) {
+            if (!blockVisited[p])
+                continue;
+            for (int r = 0; r < 32; r++) {
+                if (first) {
+                    state.known[r] = blockOut[p].known[r];
+                    state.value[r] = blockOut[p].value[r];
+                }
+                else if (!blockOut[p].known[r] || !state.known[r] || blockOut[p].value[r] != state.value[r]) {
+                    state.known[r] = false;
+                }
+            }
+            first = false;
+        }
+
+        for (const Inst& in : blocks[b].insts) {
+            if (!in.regWrite || in.rd == 0)
+                continue;
+            bool known = false;
+            int32_t value = 0;
+            if (in.kind == OP_JAL) {
+                known = true;
+                value = (int32_t)(in.pc + 4);
+            }
+            else if (in.kind != OP_LOAD) {
+                //Same datapath as RunProgram: ALU(rs1, AluSrc ? imm : rs2); LUI ignores rs1
+                bool aKnown = in.aluOp == bitset<4>(0b1000) || in.rs1 == 0 || state.known[in.rs1];
+                int32_t a = in.rs1 == 0 || in.aluOp == bitset<4>(0b1000) ? 0 : state.value[in.rs1];
+                bool bKnown = in.aluSrc || in.rs2 == 0 || state.known[in.rs2];
+                int32_t bVal = in.aluSrc ? in.imm : (in.rs2 == 0 ? 0 : state.value[in.rs2]);
+                if (aKnown && bKnown) {
+                    known = true;
+                    value = ALU_Result(a, bVal, in.aluOp);
+                }
+            }
+            state.known[in.rd] = known;
+            state.value[in.rd] = value;
+        }
+
+        bool changed = !blockVisited[b];
+        for (int r = 0; r < 32 && !changed; r++) {
+            changed = state.known[r] != blockOut[b].known[r] || (state.known[r] && state.value[r] != blockOut[b].value[r]);
+        }
+        if (!changed)
+            continue;
+        blockVisited[b] = true;
+        blockOut[b] = state;
+        for (int s : blocks[b].succs) {
+            if (s >= 0 && !queued[s]) {
+                queued[s] = true;
+                work.push_back(s);
+            }
+        }
+    }
+}
+
+WcetAnalyzer::RegState WcetAnalyzer::EntryState(const Loop& loop) const
+{
+    RegState state;
+    bool first = true;
+    if (loop.header == 0) {
+        for (int r = 0; r < 32; r++) {
+            state.known[r] = true;
+            state.value[r] = 0;
+        }
+        first = false;
+    }
+    for (int p : blocks[loop.header].preds) {
+        if (loop.blocks.count(p) || !blockVisited[p])
+            continue;
+        for (int r = 0; r < 32; r++) {
+            if (first) {
+                state.known[r] = blockOut[p].known[r];
+                state.value[r] = blockOut[p].value[r];
+            }
+            else if (!blockOut[p].known[r] || !state.known[r] || blockOut[p].value[r] != state.value[r]) {
+                state.known[r] = false;
+            }
+        }
+        first = false;
+    }
+    if (first) {
+        for (int r = 0; r < 32; r++) {
+            state.known[r] = false;
+        }
+    }
+    state.known[0] = true;
+    state.value[0] = 0;
+    return state;
+}
+
+//Smallest m >= minM with init + m * step == target (mod 2^32); false if never
+static bool SolveTrip(uint32_t init, uint32_t step, uint32_t target, unsigned long long minM, unsigned long long& m)
+{
+    if (step == 0)
+        return false;
+    uint32_t diff = target - init;
+    int tz = __builtin_ctz(step);
+    if (diff & ((1u << tz) - 1))
+        return false;
+    uint32_t oddStep = step >> tz;
+    //Inverse of an odd number mod 2^32 (Newton iteration)
+    uint32_t inv = oddStep;
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - oddStep * inv;
+    }
+    unsigned long long modulus = 1ULL << (32 - tz);
+    unsigned long long n0 = (unsigned long long)((diff >> tz) * inv) & (modulus - 1);
+    m = n0 < minM ? n0 + modulus : n0;
+    return true;
+}
+
+void WcetAnalyzer::BoundLoop(Loop& loop)
+{
+    unsigned long headerPC = blocks[loop.header].start;
+    if (userBounds.count(headerPC)) {
+        loop.bound = userBounds[headerPC];
+        loop.bounded = true;
+        loop.how = "user bound";
+        return;
+    }
+
+    vector<int> latches;
+    for (int p : blocks[loop.header].preds) {
+        if (loop.blocks.count(p))
+            latches.push_back(p);
+    }
+    //Runs exactly once per iteration: dominates every back edge source, and
+    //is not inside an inner loop, which could run it any number of times
+    int self = (int)(&loop - &loops[0]);
+    auto everyIteration = [&](int b) {
+        if (innermost[b] != self)
+            return false;
+        for (int l : latches) {
+            if (!dominators[l].count(b))
+                return false;
+        }
+        return true;
+    };
+    auto writes = [&](int r, vector<pair<int, const Inst*>>& out) {
+        for (int b : loop.blocks) {
+            for (const Inst& in : blocks[b].insts) {
+                if (in.regWrite && in.rd == r)
+                    out.push_back(make_pair(b, &in));
+            }
+        }
+    };
+
+    RegState entry = EntryState(loop);
+    for (int tb : loop.blocks) {
+        const Block& test = blocks[tb];
+        const Inst& br = test.insts.back();
+        if (br.kind != OP_BEQ || !everyIteration(tb))
+            continue;
+        //Taken edge has to leave the loop
+        int takenSucc = test.succs[0];
+        if (takenSucc >= 0 && loop.blocks.count(takenSucc))
+            continue;
+
+        const int pairs[2][2] = { { br.rs1, br.rs2 }, { br.rs2, br.rs1 } };
+        for (const auto& rt : pairs) {
+            int r = rt[0], t = rt[1];
+            if (r == 0)
+                continue;
+            vector<pair<int, const Inst*>> rWrites, tWrites;
+            writes(r, rWrites);
+            if (t != 0)
+                writes(t, tWrites);
+            if (rWrites.size() != 1 || !tWrites.empty() || !entry.known[r] || !entry.known[t])
+                continue;
+            int ib = rWrites[0].first;
+            const Inst& inc = *rWrites[0].second;
+            if (inc.kind != OP_R || inc.aluOp != bitset<4>(0b0010) || !everyIteration(ib))
+                continue;
+            if ((inc.rs1 == r) == (inc.rs2 == r))
+                continue;
+            int s = inc.rs1 == r ? inc.rs2 : inc.rs1;
+            vector<pair<int, const Inst*>> sWrites;
+            if (s != 0)
+                writes(s, sWrites);
+            if (!sWrites.empty() || !entry.known[s])
+                continue;
+
+            //Does the add run before the test within an iteration?
+            unsigned long long addFirst = (ib == tb || (dominators[tb].count(ib) && ib != tb)) ? 1 : 0;
+            unsigned long long m;
+            if (!SolveTrip((uint32_t)entry.value[r], (uint32_t)entry.value[s], (uint32_t)entry.value[t], addFirst, m))
+                continue;
+            unsigned long long bound = m - addFirst + 1;
+            if (!loop.bounded || bound < loop.bound) {
+                loop.bound = bound;
+                loop.bounded = true;
+                stringstream how;
+                how << "x" << r << " from " << entry.value[r] << " step " << entry.value[s] << " until x" << t
+                    << " (" << entry.value[t] << ") at " << Hex(br.pc);
+                loop.how = how.str();
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// LONGEST PATHS
+//////////////////////////////////////////////////////////////////////
+
+//Node standing for `block` in the region of loop `loop` (-1 = top level): the block itself,
+//or the header of the child loop that contains it. -2 when the block is outside the region.
+int WcetAnalyzer::Representative(int block, int loop) const
+{
+    if (block < 0)
+        return -2;
+    if (loop >= 0 && !loops[loop].blocks.count(block))
+        return -2;
+    int l = innermost[block];
+    if (l == loop)
+        return block;
+    while (l >= 0 && loops[l].parent != loop) {
+        l = loops[l].parent;
+    }
+    return l >= 0 ? loops[l].header : block;
+}
+
+string WcetAnalyzer::NodeName(int node, int loop) const
+{
+    if (innermost[node] >= 0 && loops[innermost[node]].header != node) {
+        return Hex(blocks[node].start);
+    }
+    for (size_t l = 0; l < loops.size(); l++) {
+        if (loops[l].header == node && (int)l != loop) {
+            stringstream ss;
+            ss << "[loop " << Hex(blocks[node].start) << " x" << loops[l].bound << "]";
+            return ss.str();
+        }
+    }
+    return Hex(blocks[node].start);
+}
+
+bool WcetAnalyzer::LongestPath(int loop, unsigned long long& cost, vector<int>& path)
+{
+    int source = loop >= 0 ? loops[loop].header : Representative(0, -1);
+    auto childLoop = [&](int node) {
+        for (size_t l = 0; l < loops.size(); l++) {
+            if (loops[l].header == node && (int)l != loop)
+                return (int)l;
+        }
+        return -1;
+    };
+    auto nodeCost = [&](int node) {
+        int child = childLoop(node);
+        return child >= 0 ? SatMul(loops[child].bound, loops[child].iterCost) : blocks[node].cost;
+    };
+    //Edges leaving a node: (successor block, weight); a collapsed loop leaves through its exits
+    auto edges = [&](int node, vector<pair<int, unsigned long long>>& out) {
+        int child = childLoop(node);
+        vector<int> members;
+        if (child >= 0)
+            members.assign(loops[child].blocks.begin(), loops[child].blocks.end());
+        else
+            members.push_back(node);
+        for (int b : members) {
+            for (size_t e = 0; e < blocks[b].succs.size(); e++) {
+                int s = blocks[b].succs[e];
+                if (child >= 0 && s >= 0 && loops[child].blocks.count(s))
+                    continue;
+                out.push_back(make_pair(s, blocks[b].takenEdge[e] ? table.takenPenalty : 0));
+            }
+        }
+    };
+
+    //DFS topological order of the region's DAG (back edges to our own header are terminals)
+    map<int, int> color;
+    vector<int> order;
+    bool cyclic = false;
+    vector<pair<int, size_t>> stack;
+    map<int, vector<pair<int, unsigned long long>>> out;
+    stack.push_back(make_pair(source, 0));
+    color[source] = 1;
+    edges(source, out[source]);
+    while (!stack.empty()) {
+        int n = stack.back().first;
+        size_t& i = stack.back().second;
+        if (i == out[n].size()) {
+            color[n] = 2;
+            order.push_back(n);
+            stack.pop_back();
+            continue;
+        }
+        int s = out[n][i++].first;
+        int rep = Representative(s, loop);
+        if (rep < 0 || (loop >= 0 && rep == loops[loop].header))
+            continue;
+        if (color[rep] == 1) {
+            cyclic = true;
+            continue;
+        }
+        if (color[rep] == 0) {
+            color[rep] = 1;
+            edges(rep, out[rep]);
+            stack.push_back(make_pair(rep, 0));
+        }
+    }
+    if (cyclic) {
+        problems.push_back("irreducible control flow in " + (loop >= 0 ? "loop " + Hex(blocks[loops[loop].header].start) : string("program")));
+        return false;
+    }
+    reverse(order.begin(), order.end());
+
+    map<int, unsigned long long> dist;
+    map<int, int> prev;
+    dist[source] = nodeCost(source);
+    prev[source] = -1;
+    cost = 0;
+    int bestEnd = -1;
+    bool anyTerminal = false;
+    for (int n : order) {
+        for (const pair<int, unsigned long long>& e : out[n]) {
+            int rep = Representative(e.first, loop);
+            unsigned long long d = SatAdd(dist[n], e.second);
+            bool terminal = loop >= 0 ? (rep < 0 || rep == loops[loop].header) : e.first < 0;
+            if (terminal) {
+                anyTerminal = true;
+                if (bestEnd < 0 || d > cost) {
+                    cost = d;
+                    bestEnd = n;
+                }
+                continue;
+            }
+            if (rep < 0)
+                continue;
+            unsigned long long nd = SatAdd(d, nodeCost(rep));
+            if (!dist.count(rep) || nd > dist[rep]) {
+                dist[rep] = nd;
+                prev[rep] = n;
+            }
+        }
+    }
+    if (!anyTerminal) {
+        problems.push_back(loop >= 0 ? "loop " + Hex(blocks[loops[loop].header].start) + " never repeats or exits"
+                                     : string("the program can never leave its code (no path to an exit)"));
+        return false;
+    }
+    path.clear();
+    for (int n = bestEnd; n >= 0; n = prev[n]) {
+        path.push_back(n);
+    }
+    reverse(path.begin(), path.end());
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// DRIVER
+//////////////////////////////////////////////////////////////////////
+
+bool WcetAnalyzer::Analyze()
+{
+    BuildCFG();
+    if (blocks.empty()) {
+        wcet = 0;
+        return true;
+    }
+    ComputeDominators();
+    PropagateConstants();
+    FindLoops();
+
+    //Innermost first: a loop only needs its children's totals
+    vector<int> byDepth;
+    for (size_t l = 0; l < loops.size(); l++) {
+        byDepth.push_back((int)l);
+    }
+    sort(byDepth.begin(), byDepth.end(), [&](int a, int b) { return loops[a].blocks.size() < loops[b].blocks.size(); });
+    bool ok = problems.empty();
+    for (int l : byDepth) {
+        BoundLoop(loops[l]);
+        if (!loops[l].bounded) {
+            problems.push_back("no bound for loop at " + Hex(blocks[loops[l].header].start)
+                + " (not a simple induction; pass --wcet-bound " + Hex(blocks[loops[l].header].start) + ":N)");
+            ok = false;
+            continue;
+        }
+        if (!LongestPath(l, loops[l].iterCost, loops[l].criticalIteration))
+            ok = false;
+    }
+    if (!ok)
+        return false;
+    return LongestPath(-1, wcet, criticalPath);
+}
+
+void WcetAnalyzer::Report(ostream& out) const
+{
+    out << "[WCET] " << blocks.size() << " basic blocks, " << loops.size() << " loops" << endl;
+    for (size_t l = 0; l < loops.size(); l++) {
+        const Loop& loop = loops[l];
+        out << "  loop " << Hex(blocks[loop.header].start) << ": ";
+        if (!loop.bounded) {
+            out << "unbounded" << endl;
+            continue;
+        }
+        out << loop.bound << " iterations (" << loop.how << "), " << loop.iterCost << " cycles per iteration, "
+            << SatMul(loop.bound, loop.iterCost) << " total" << endl;
+        if (!loop.criticalIteration.empty()) {
+            out << "    worst iteration:";
+            for (int n : loop.criticalIteration) {
+                out << " " << NodeName(n, (int)l);
+            }
+            out << endl;
+        }
+    }
+    for (const string& p : problems) {
+        out << "[WCET] " << p << endl;
+    }
+    if (!problems.empty()) {
+        out << "[WCET] no safe bound" << endl;
+        return;
+    }
+    out << "[WCET] upper bound: " << wcet << " cycles" << (wcet == ULLONG_MAX ? " (saturated)" : "") << endl;
+    out << "  critical path:";
+    for (int n : criticalPath) {
+        out << " " << NodeName(n, -1);
+    }
+    out << " -> exit" << endl;
+}
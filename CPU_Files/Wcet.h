@@ -0,0 +1,119 @@
+#pragma once
+#include "CPU.h"
+#include <map>
+#include <set>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// STATIC WORST CASE EXECUTION TIME
+//
+// Builds the CFG of the loaded program from BEQ and JAL targets, finds
+// natural loops through dominators, and bounds each loop by its induction
+// pattern:
+//   * the loop's only write to r is `add r, r, s` (or `add r, s, r`),
+//     where s is loop invariant and constant on entry,
+//   * an exit `beq r, t` is taken out of the loop, t is loop invariant and
+//     constant on entry,
+//   * both run on every iteration (they dominate every back edge).
+// The trip count then follows from solving init + n*step == t (mod 2^32).
+// Other loops need a user bound (header PC -> iterations).
+//
+// Loops are collapsed innermost first into nodes costing
+// bound * (longest single iteration). The WCET is the longest path
+// through the remaining DAG, which is safe because every iteration is
+// charged its worst path.
+//////////////////////////////////////////////////////////////////////
+
+enum OpClass { OP_R, OP_I, OP_LUI, OP_LOAD, OP_STORE, OP_BEQ, OP_JAL, OP_OTHER, NUM_OP_CLASSES };
+
+struct LatencyTable {
+	unsigned cycles[NUM_OP_CLASSES] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+	unsigned takenPenalty = 0; //extra cycles when a BEQ is taken (JAL is always charged its own latency)
+
+	//Lines of "<class> <cycles>": r, i, lui, load, store, beq, jal, other, taken. '#' starts a comment.
+	//Returns false if the file cannot be read or has an unknown class.
+	bool Load(const char* fileName);
+	static OpClass Classify(const Controller& ctrl);
+};
+
+//Cycle count of an actual run under the same table (checks the static bound)
+class CycleCounter {
+public:
+	explicit CycleCounter(const LatencyTable& table) : table(table) {}
+	void Retire(const Controller& ctrl, bool taken);
+	unsigned long long cycles = 0;
+
+private:
+	const LatencyTable& table;
+};
+
+class WcetAnalyzer {
+public:
+	WcetAnalyzer(unsigned char instMem[], int maxPC, const LatencyTable& table);
+
+	//User supplied bound for the loop whose header is at pc (header executions)
+	void SetLoopBound(unsigned long headerPC, unsigned long long iterations) { userBounds[headerPC] = iterations; }
+
+	//False if some loop has no bound or the CFG is irreducible; the report says why
+	bool Analyze();
+	unsigned long long wcet = 0;
+	void Report(ostream& out) const;
+
+private:
+	struct Inst {
+		unsigned long pc;
+		OpClass kind;
+		int rd, rs1, rs2;
+		int32_t imm;
+		bool regWrite, aluSrc;
+		bitset<4> aluOp;
+	};
+	struct Block {
+		unsigned long start;
+		vector<Inst> insts;
+		vector<int> succs;       //block indices, -1 = leaves the program
+		vector<bool> takenEdge;  //succs[i] is a taken BEQ edge
+		vector<int> preds;
+		unsigned long long cost = 0;
+	};
+	struct Loop {
+		int header;
+		set<int> blocks;
+		int parent = -1;
+		unsigned long long bound = 0;
+		bool bounded = false;
+		string how;                    //how the bound was found
+		unsigned long long iterCost = 0;
+		vector<int> criticalIteration; //region nodes of the longest iteration
+	};
+
+	unsigned char* instMem;
+	int maxPC;
+	const LatencyTable& table;
+	map<unsigned long, unsigned long long> userBounds;
+
+	vector<Block> blocks;
+	vector<set<int>> dominators;
+	vector<Loop> loops;
+	vector<int> innermost;          //innermost loop of each block, -1 if none
+	vector<int> criticalPath;       //top level region nodes
+	vector<string> problems;
+
+	//Constant propagation: per register, known value or not
+	struct RegState {
+		bool known[32];
+		int32_t value[32];
+	};
+	vector<RegState> blockOut;
+	vector<bool> blockVisited;
+
+	void BuildCFG();
+	void ComputeDominators();
+	void FindLoops();
+	void PropagateConstants();
+	void BoundLoop(Loop& loop);
+	int Representative(int block, int loop) const;
+	bool LongestPath(int loop, unsigned long long& cost, vector<int>& path);
+	RegState EntryState(const Loop& loop) const;
+	string NodeName(int node, int loop) const;
+};
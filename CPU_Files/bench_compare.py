@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Compare cpubench JSON results against a stored baseline.
+
+Usage:
+    python3 bench_compare.py baseline.json current.json [--metric batch_p50] [--threshold 10]
+
+A benchmark is flagged as a regression when the chosen metric grew by more
+than --threshold percent. Exit status is 1 if anything regressed, so the
+script can gate a CI job.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag cpubench regressions against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--metric", default="batch_p50", choices=["mean", "batch_p50", "batch_p99"])
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print(f"{'benchmark':40} {'baseline':>12} {'current':>12} {'change':>9}")
+    for name, cur in current.items():
+        if name not in baseline:
+            print(f"{name:40} {'-':>12} {cur[args.metric]:12.2f}      new")
+            continue
+        base = baseline[name][args.metric]
+        change = (cur[args.metric] - base) / base * 100.0 if base > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  << REGRESSION"
+            regressions += 1
+        print(f"{name:40} {base:12.2f} {cur[args.metric]:12.2f} {change:+8.1f}%{flag}")
+    for name in baseline:
+        if name not in current:
+            print(f"{name:40} {baseline[name][args.metric]:12.2f} {'-':>12}  missing")
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) regressed by more than {args.threshold}% ({args.metric})")
+        return 1
+    print(f"\nNo regressions above {args.threshold}% ({args.metric})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+#include "CacheSim.h"
+
+#include <fstream>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// OFFLINE CACHE SIMULATION
+//
+// Replays a memory trace recorded with `cpusim --mem-trace` through one
+// or more cache configurations in a single pass. The guest does not have
+// to run again for every geometry being compared.
+//
+// Usage: cachesim --cache SPEC [--cache SPEC]... [--top N] <trace_file>
+//////////////////////////////////////////////////////////////////////
+
+static void printUsage()
+{
+	cout << "Usage: cachesim --cache size:assoc:line[:lru|plru|random] [--cache ...] [--top N] <trace_file>" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	CacheSim caches;
+	size_t topPCs = 10;
+	const char* fileName = nullptr;
+	for (int a = 1; a < argc; a++) {
+		string arg = argv[a];
+		if (arg == "--cache" && a + 1 < argc) {
+			CacheConfig config;
+			if (!CacheConfig::Parse(argv[++a], config)) {
+				cout << "bad cache spec " << argv[a] << endl;
+				return -1;
+			}
+			caches.AddConfig(config);
+		}
+		else if (arg == "--top" && a + 1 < argc)
+			topPCs = strtoul(argv[++a], nullptr, 10);
+		else if (arg.rfind("--", 0) == 0) {
+			printUsage();
+			return -1;
+		}
+		else
+			fileName = argv[a];
+	}
+	if (fileName == nullptr || caches.Empty()) {
+		printUsage();
+		return -1;
+	}
+
+	ifstream trace(fileName);
+	if (!trace) {
+		cout << "error opening " << fileName << endl;
+		return -1;
+	}
+	long long records = ReplayTrace(trace, caches);
+	if (records < 0) {
+		cout << "malformed trace " << fileName << endl;
+		return -1;
+	}
+	cout << records << " accesses" << endl;
+	caches.Report(cout, topPCs);
+	return 0;
+}
@@ -0,0 +1,195 @@
+#include "CPU.h"
+#include "Simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////
+// MICROBENCHMARKS
+//
+// Times every datapath component and the whole run loop on the trace
+// programs. Each benchmark collects `samples` timings of `calls` back to
+// back calls and reports, in nanoseconds per call, the mean and the p50
+// and p99 of those batch means as JSON. Averaging a batch hides the tail
+// of single calls (most are too short to time one by one), so
+// batch_p99 is not a per-call p99. Compare two result files with
+// bench_compare.py.
+//
+// Usage: cpubench [--samples N] [--out results.json] [trace files...]
+//////////////////////////////////////////////////////////////////////
+
+struct BenchResult {
+	string name;
+	long calls;
+	double mean, batchP50, batchP99;  //percentiles over the per-call means of each batch
+};
+
+//Results go through this so the compiler cannot drop the calls
+static volatile int64_t sink;
+
+template <typename F>
+static BenchResult Bench(const string& name, int samples, long calls, F fn)
+{
+	vector<double> batchMeans;
+	//Warm-up pass (caches, branch predictor, page faults) is not recorded
+	for (long c = 0; c < calls; c++) {
+		sink = sink + fn(c);
+	}
+	for (int s = 0; s < samples; s++) {
+		int64_t acc = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (long c = 0; c < calls; c++) {
+			acc += fn(c);
+		}
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		sink = sink + acc;
+		batchMeans.push_back(chrono::duration<double, nano>(end - start).count() / calls);
+	}
+	sort(batchMeans.begin(), batchMeans.end());
+
+	BenchResult r;
+	r.name = name;
+	r.calls = calls * samples;
+	double sum = 0;
+	for (double v : batchMeans) {
+		sum += v;
+	}
+	r.mean = sum / batchMeans.size();
+	r.batchP50 = batchMeans[batchMeans.size() / 2];
+	r.batchP99 = batchMeans[min(batchMeans.size() - 1, (size_t)(batchMeans.size() * 0.99))];
+	return r;
+}
+
+//Little endian bytes of one instruction word, as they sit in instruction memory
+static Instruction MakeInstruction(uint32_t word)
+{
+	unsigned char mem[4] = {
+		(unsigned char)(word & 0xFF), (unsigned char)((word >> 8) & 0xFF),
+		(unsigned char)((word >> 16) & 0xFF), (unsigned char)((word >> 24) & 0xFF) };
+	return Instruction(mem, 0UL);
+}
+
+int main(int argc, char* argv[])
+{
+	int samples = 200;
+	string outFile;
+	vector<string> traces;
+	for (int a = 1; a < argc; a++) {
+		string arg = argv[a];
+		if (arg == "--samples" && a + 1 < argc)
+			samples = atoi(argv[++a]);
+		else if (arg == "--out" && a + 1 < argc)
+			outFile = argv[++a];
+		else
+			traces.push_back(arg);
+	}
+	if (traces.empty()) {
+		traces = { "Test/trace/24instMem-r.txt", "Test/trace/24instMem-swr.txt", "Test/trace/24instMem-jswr.txt" };
+	}
+
+	//One instruction of every format (taken from Test/trace/24jswr.txt)
+	const pair<string, uint32_t> formats[] = {
+		{ "R", 0x00730e33 },      //add x28 x6 x7
+		{ "I_ORI", 0x09a06293 },  //ori x5 x0 154
+		{ "I_SRAI", 0x4032d393 }, //srai x7 x5 3
+		{ "U", 0x000012b7 },      //lui x5 0x1
+		{ "L", 0x003e2503 },      //lw x10 3 x28
+		{ "S", 0x00a02023 },      //sw x10 0 x0
+		{ "B", 0x00b50463 },      //beq x10 x11 8
+		{ "J", 0x00c0056f },      //jal x10 12
+	};
+	vector<Instruction> all;
+	for (const pair<string, uint32_t>& f : formats) {
+		all.push_back(MakeInstruction(f.second));
+	}
+	const long N = 1000;
+	vector<BenchResult> results;
+
+	results.push_back(Bench("toBigEndian", samples, N, [](long c) {
+		return (int64_t)toBigEndian((uint32_t)c * 2654435761u);
+	}));
+
+	for (size_t f = 0; f < all.size(); f++) {
+		Instruction inst = all[f];
+		results.push_back(Bench("ImmGen/" + formats[f].first, samples, N, [&inst](long) {
+			return (int64_t)ImmGen(inst);
+		}));
+	}
+
+	results.push_back(Bench("Controller", samples, N, [&all](long c) {
+		Controller ctrl(all[c % all.size()]);
+		return (int64_t)ctrl.ALUOp.to_ulong() + ctrl.regWrite;
+	}));
+
+	vector<bitset<2>> aluOps;
+	for (const Instruction& inst : all) {
+		aluOps.push_back(Controller(inst).ALUOp);
+	}
+	results.push_back(Bench("ALU_Controller", samples, N, [&all, &aluOps](long c) {
+		ALU_Controller alu(all[c % all.size()], aluOps[c % all.size()]);
+		return (int64_t)alu.ALUOp.to_ulong();
+	}));
+
+	const pair<string, int> aluOpNames[] = {
+		{ "ADD", 0b0010 }, { "SUB", 0b0110 }, { "AND", 0b0000 }, { "OR", 0b0001 },
+		{ "XOR", 0b0011 }, { "SRAI", 0b0100 }, { "LUI", 0b1000 }, { "JAL", 0b1111 },
+	};
+	for (const pair<string, int>& op : aluOpNames) {
+		bitset<4> aluOp(op.second);
+		results.push_back(Bench("ALU_Result/" + op.first, samples, N, [aluOp](long c) {
+			return (int64_t)ALU_Result((int)c, 3, aluOp);
+		}));
+	}
+
+	CPU cpu;
+	results.push_back(Bench("DataMemory/store_word", samples, N, [&cpu](long c) {
+		return (int64_t)cpu.DataMemory(1, 0, (int)(c % 4096) * 4, (int)c, true);
+	}));
+	results.push_back(Bench("DataMemory/store_byte", samples, N, [&cpu](long c) {
+		return (int64_t)cpu.DataMemory(1, 0, (int)(c % 4096) * 4, (int)c, false);
+	}));
+	results.push_back(Bench("DataMemory/load_word", samples, N, [&cpu](long c) {
+		return (int64_t)cpu.DataMemory(0, 1, (int)(c % 4096) * 4, 0, true);
+	}));
+	results.push_back(Bench("DataMemory/load_byte", samples, N, [&cpu](long c) {
+		return (int64_t)cpu.DataMemory(0, 1, (int)(c % 4096) * 4, 0, false);
+	}));
+
+	//END TO END: one call = one whole program run
+	for (const string& trace : traces) {
+		unsigned char instMem[4096];
+		int maxPC = LoadProgram(trace.c_str(), instMem);
+		if (maxPC < 0) {
+			cerr << "error opening " << trace << endl;
+			continue;
+		}
+		SimOptions options;
+		results.push_back(Bench("RunProgram/" + trace.substr(trace.find_last_of("/\\") + 1), samples, 10, [&](long) {
+			int registers[32];
+			return (int64_t)RunProgram(instMem, maxPC, options, registers) + registers[10];
+		}));
+	}
+
+	//JSON REPORT
+	ofstream file;
+	if (!outFile.empty()) {
+		file.open(outFile);
+		if (!file) {
+			cerr << "error opening " << outFile << endl;
+			return 1;
+		}
+	}
+	ostream& out = outFile.empty() ? cout : file;
+	out << "{\n  \"unit\": \"ns_per_call\",\n  \"benchmarks\": [\n";
+	for (size_t r = 0; r < results.size(); r++) {
+		const BenchResult& b = results[r];
+		out << "    {\"name\": \"" << b.name << "\", \"calls\": " << b.calls
+			<< ", \"mean\": " << b.mean << ", \"batch_p50\": " << b.batchP50 << ", \"batch_p99\": " << b.batchP99 << "}"
+			<< (r + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+	return 0;
+}
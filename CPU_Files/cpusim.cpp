@@ -1,4 +1,14 @@
 #include "CPU.h"
+#include "MultiHart.h"
+#include "Simulator.h"
+#include "HostPerf.h"
+#include "CacheSim.h"
+#include "BranchPredictor.h"
+#include "SimPoint.h"
+#include "Wcet.h"
+#include "Devices.h"
+#include "Events.h"
+#include "Replay.h"
 
 #include <iostream>
 #include <bitset>
@@ -18,6 +28,38 @@ Add all the required standard and developed libraries here
 Put/Define any helper function/definitions you need here
 */
 
+//Command line: cpusim [options] <instruction_file>
+//  --harts N        run N harts sharing one data memory (each on its own host thread)
+//  --rr-quantum Q   deterministic round robin: harts take turns for Q instructions on one thread
+//  --det-quantum Q  deterministic parallel mode: harts run Q instructions, then stores commit in hart order
+//  --threads T      host threads for --det-quantum (default: one per hart, capped by cores)
+//  --atomics        enable LR.W/SC.W/AMOSWAP.W/AMOADD.W
+//  --max-steps N    per-hart instruction budget for multi-hart runs (0 = unlimited)
+//  --detect-loops   stop with a report when the guest state repeats (Brent's algorithm)
+//  --perf           report host cycles per guest instruction, IPC, branch misses, LLC misses (stderr)
+//  --cache SPEC     model a split L1 cache, SPEC = size:assoc:line[:lru|plru|random]; repeat to compare configs
+//  --mem-trace FILE record every fetch, load and store for offline runs with cachesim
+//  --bpred SPEC     model a branch predictor (static, bimodal[:bits], gshare[:bits[:hist]], tage); repeat to compare
+//  --simpoint N     sampled simulation: cluster N-instruction intervals, time only representatives (first --cache/--bpred is the model)
+//  --sp-maxk K      most clusters to try (default 10)
+//  --sp-samples M   intervals simulated per cluster (default 2, needed for error bounds)
+//  --sp-warmup W    instructions run before each sample to warm the model (default one interval)
+//  --sp-full        also time the whole program and report the estimate's real error
+//  --wcet           static worst case cycle bound, then run and compare with the observed cycles
+//  --latency FILE   per opcode latency table for --wcet (lines of "<r|i|lui|load|store|beq|jal|other|taken> cycles")
+//  --wcet-bound PC:N  iteration bound for the loop headed at PC when no induction pattern is found
+//  --devices        map the input FIFO (0x4000), UART (0x4100) and timer (0x4200) past the end of RAM
+//  --input FILE     values for the input FIFO, one per line (implies --devices)
+//  --uart-out FILE  where UART output goes, default stdout (implies --devices)
+//  --interrupts     map the interrupt controller (0x4300) and let the timer raise line 0 (implies --devices)
+//  --record FILE    log every input device read and interrupt with its instruction count (implies --devices)
+//  --replay FILE    rerun a recorded or model checker log exactly, without the input file (implies --devices)
+//  --exec-trace FILE  one line per retired instruction: instret, PC, encoding, register written
+static void printUsage()
+{
+	cout << "Usage: cpusim [--harts N] [--rr-quantum Q] [--det-quantum Q] [--threads T] [--atomics] [--max-steps N] [--detect-loops] [--perf] [--cache SPEC]... [--mem-trace FILE] [--bpred SPEC]... [--simpoint N [--sp-maxk K] [--sp-samples M] [--sp-warmup W] [--sp-full]] [--wcet [--latency FILE] [--wcet-bound PC:N]...] [--devices] [--input FILE] [--uart-out FILE] [--interrupts] [--record FILE | --replay FILE] [--exec-trace FILE] <instruction_file>" << endl;
+}
+
 
 
 
@@ -38,165 +80,296 @@ int main(int argc, char* argv[])
 		return -1;
 	}
 
-	ifstream infile(argv[1]); //open the file
-	if (!(infile.is_open() && infile.good())) {
+	MultiHartConfig hartConfig;
+	bool detectLoops = false;
+	bool perf = false;
+	CacheSim caches;
+	string memTraceFile;
+	BranchModel branches;
+	SimPointConfig spConfig;
+	bool simpoint = false;
+	bool spWarmupGiven = false;
+	bool wcet = false;
+	LatencyTable latencies;
+	vector<pair<unsigned long, unsigned long long>> loopBounds;
+	bool devices = false;
+	bool interrupts = false;
+	const char* inputFile = nullptr;
+	const char* uartFile = nullptr;
+	const char* recordFile = nullptr;
+	const char* replayFile = nullptr;
+	const char* execTraceFile = nullptr;
+	const char* fileName = nullptr;
+	for (int a = 1; a < argc; a++) {
+		string arg = argv[a];
+		if (arg == "--harts" && a + 1 < argc)
+			hartConfig.numHarts = atoi(argv[++a]);
+		else if (arg == "--rr-quantum" && a + 1 < argc)
+			hartConfig.rrQuantum = atoi(argv[++a]);
+		else if (arg == "--det-quantum" && a + 1 < argc)
+			hartConfig.detQuantum = atoi(argv[++a]);
+		else if (arg == "--threads" && a + 1 < argc)
+			hartConfig.numThreads = atoi(argv[++a]);
+		else if (arg == "--atomics")
+			hartConfig.atomics = true;
+		else if (arg == "--max-steps" && a + 1 < argc)
+			hartConfig.maxSteps = strtoull(argv[++a], nullptr, 10);
+		else if (arg == "--detect-loops")
+			detectLoops = true;
+		else if (arg == "--perf")
+			perf = true;
+		else if (arg == "--cache" && a + 1 < argc) {
+			CacheConfig config;
+			if (!CacheConfig::Parse(argv[++a], config)) {
+				cout << "bad cache spec " << argv[a] << " (expected size:assoc:line[:lru|plru|random], powers of two)" << endl;
+				return -1;
+			}
+			if (caches.Empty())
+				spConfig.cacheSpec = argv[a];
+			caches.AddConfig(config);
+		}
+		else if (arg == "--mem-trace" && a + 1 < argc)
+			memTraceFile = argv[++a];
+		else if (arg == "--bpred" && a + 1 < argc) {
+			unique_ptr<BranchPredictor> predictor = BranchPredictor::Create(argv[++a]);
+			if (!predictor) {
+				cout << "bad branch predictor " << argv[a] << " (expected static, bimodal[:bits], gshare[:bits[:hist]] or tage)" << endl;
+				return -1;
+			}
+			if (branches.Empty())
+				spConfig.predictorSpec = argv[a];
+			branches.AddPredictor(move(predictor));
+		}
+		else if (arg == "--simpoint" && a + 1 < argc) {
+			simpoint = true;
+			spConfig.intervalSize = strtoull(argv[++a], nullptr, 10);
+		}
+		else if (arg == "--sp-maxk" && a + 1 < argc)
+			spConfig.maxK = atoi(argv[++a]);
+		else if (arg == "--sp-samples" && a + 1 < argc)
+			spConfig.samplesPerCluster = max(1, atoi(argv[++a]));
+		else if (arg == "--sp-warmup" && a + 1 < argc) {
+			spConfig.warmup = strtoull(argv[++a], nullptr, 10);
+			spWarmupGiven = true;
+		}
+		else if (arg == "--sp-full")
+			spConfig.compareFull = true;
+		else if (arg == "--devices")
+			devices = true;
+		else if (arg == "--interrupts") {
+			devices = true;
+			interrupts = true;
+		}
+		else if (arg == "--record" && a + 1 < argc) {
+			devices = true;
+			recordFile = argv[++a];
+		}
+		else if (arg == "--replay" && a + 1 < argc) {
+			devices = true;
+			replayFile = argv[++a];
+		}
+		else if (arg == "--exec-trace" && a + 1 < argc)
+			execTraceFile = argv[++a];
+		else if (arg == "--input" && a + 1 < argc) {
+			devices = true;
+			inputFile = argv[++a];
+		}
+		else if (arg == "--uart-out" && a + 1 < argc) {
+			devices = true;
+			uartFile = argv[++a];
+		}
+		else if (arg == "--wcet")
+			wcet = true;
+		else if (arg == "--latency" && a + 1 < argc) {
+			if (!latencies.Load(argv[++a])) {
+				cout << "bad latency table " << argv[a] << endl;
+				return -1;
+			}
+		}
+		else if (arg == "--wcet-bound" && a + 1 < argc) {
+			string spec = argv[++a];
+			size_t colon = spec.find(':');
+			if (colon == string::npos) {
+				printUsage();
+				return -1;
+			}
+			loopBounds.push_back(make_pair(strtoul(spec.substr(0, colon).c_str(), nullptr, 0), strtoull(spec.substr(colon + 1).c_str(), nullptr, 0)));
+		}
+		else if (arg.rfind("--", 0) == 0) {
+			printUsage();
+			return -1;
+		}
+		else
+			fileName = argv[a];
+	}
+	if (fileName == nullptr || hartConfig.numHarts < 1) {
+		printUsage();
+		return -1;
+	}
+	//The multi-hart runner has none of the single-hart models, traces or devices
+	bool multiHart = hartConfig.numHarts > 1 || hartConfig.rrQuantum > 0 || hartConfig.detQuantum > 0 || hartConfig.atomics;
+	if (multiHart && (detectLoops || !caches.Empty() || !memTraceFile.empty() || !branches.Empty() || simpoint || wcet || devices || execTraceFile)) {
+		cout << "multi-hart runs (--harts, --rr-quantum, --det-quantum, --atomics) do not support --detect-loops, --cache, --mem-trace, --bpred, --simpoint, --wcet, --exec-trace or the device options" << endl;
+		printUsage();
+		return -1;
+	}
+
+	int maxPC = LoadProgram(fileName, instMem);
+	if (maxPC < 0) {
 		cout << "error opening file\n";
 		return 0;
 	}
 
-	string line;
-	int i = 0;
-	
-	// Read each line in the input file, assuming each line represents 1 byte in hexadecimal
-	while (std::getline(infile, line) && i < 4096) {
-		std::stringstream line2(line);
-		int hexValue;
+	//MULTI-HART: every hart runs the same program and prints its own (a0,a1)
+	if (multiHart) {
+		SharedMemory sharedMem;
+		HostPerf hostPerf;
+		hostPerf.Start();
+		vector<Hart> harts = RunMultiHart(instMem, maxPC, hartConfig, sharedMem);
+		hostPerf.Stop();
+		unsigned long long totalInstret = 0;
+		for (Hart& hart : harts) {
+			cout << "hart " << hart.id << ": (" << hart.registers[10] << "," << hart.registers[11] << ")" << endl;
+			totalInstret += hart.instret;
+		}
+		if (perf)
+			hostPerf.Report(cerr, totalInstret);
+		return 0;
+	}
 
-		// Convert each hex line to an integer, then cast it to char and store in instMem
-		line2 >> std::hex >> hexValue;
-		instMem[i] = static_cast<char>(hexValue);
 
-		i++;
+	//SAMPLED: functional profile, then detailed timing of representative intervals only
+	if (simpoint) {
+		spConfig.detectLoops = detectLoops;
+		if (!spWarmupGiven)
+			spConfig.warmup = spConfig.intervalSize;
+		int registers[32];
+		RunSimPoint(instMem, maxPC, spConfig, registers, cerr);
+		cout << "(" << registers[10] << "," << registers[11] << ")" << endl;
+		return 0;
 	}
-	int maxPC = i;
 
+	//WCET: static bound first, the run below reports the cycles it actually took
+	CycleCounter cycleCount(latencies);
+	bool wcetBounded = false;
+	unsigned long long wcetBound = 0;
+	if (wcet) {
+		WcetAnalyzer analyzer(instMem, maxPC, latencies);
+		for (const pair<unsigned long, unsigned long long>& b : loopBounds) {
+			analyzer.SetLoopBound(b.first, b.second);
+		}
+		wcetBounded = analyzer.Analyze();
+		wcetBound = analyzer.wcet;
+		analyzer.Report(cerr);
+	}
 
-	/* Instantiate your CPU object here.  CPU class is the main class in this project that defines different components of the processor.
-	CPU class also has different functions for each stage (e.g., fetching an instruction, decoding, etc.).
-	*/
+	//DEVICES: flushed when they go out of scope at the end of main
+	MMIOBus bus;
+	InputFifo inputFifo;
+	ofstream uartStream;
+	if (uartFile) {
+		uartStream.open(uartFile);
+		if (!uartStream) {
+			cout << "error opening " << uartFile << endl;
+			return -1;
+		}
+	}
+	Uart uart(uartFile ? (ostream&)uartStream : cout);
+	Timer timer(bus);
+	if (inputFile && !inputFifo.Load(inputFile)) {
+		cout << "error opening " << inputFile << endl;
+		return -1;
+	}
+	//Record and replay sit between the bus and the input FIFO
+	ReplayLog replayLog;
+	if (replayFile && !replayLog.Load(replayFile)) {
+		cout << "bad replay log " << replayFile << endl;
+		return -1;
+	}
+	ReplaySession replay(replayLog, replayFile != nullptr, bus);
+	bool logging = recordFile || replayFile;
+	bus.Map(MMIOBus::INPUT_FIFO_BASE, 1 << MMIOBus::PAGE_BITS, logging ? replay.InputPort(&inputFifo) : &inputFifo);
+	bus.Map(MMIOBus::UART_BASE, 1 << MMIOBus::PAGE_BITS, &uart);
+	bus.Map(MMIOBus::TIMER_BASE, 1 << MMIOBus::PAGE_BITS, &timer);
+	InterruptController irq;
+	EventScheduler events(irq);
+	if (interrupts) {
+		bus.Map(MMIOBus::IRQ_BASE, 1 << MMIOBus::PAGE_BITS, &irq);
+		timer.Connect(&events, InterruptController::TIMER_LINE);
+	}
 
-	CPU myCPU;  // call the approriate constructor here to initialize the processor...  
-	// make sure to create a variable for PC and resets it to zero (e.g., unsigned int PC = 0); 
-
-	//REGISTERS and their values (All set to zero to start)
-	const int NUM_REGISTERS = 32;
-	int registers[NUM_REGISTERS] = { 0 };
-
-
-
-	bool done = true;
-	while (done == true) // processor's main loop. Each iteration is equal to one clock cycle.  
-	{
-		///////////////
-		//// FETCH ////
-		///////////////
-
-		//Only make an instruction if its 32 more bits
-		if (i - myCPU.readPC() < 4)
-			break;
-
-		 // --- DEBUG: Print all register values after this instruction ---
-    	/*cout << "PC: " << myCPU.readPC() << " | Registers: ";
-    	for (int r = 0; r < NUM_REGISTERS; r++) {
-        	cout << "x" << r << "=" << registers[r] << " ";
-    	}
-    	cout << endl;*/
-		
-		/* Instantiate your Instruction object here. */
-		Instruction myInst(instMem, myCPU); 
-
-		//Getting the next PC without jumps
-		unsigned long nextPC = myCPU.readPC() + 4;
-
-		////////////////
-		//// DECODE	////
-		////////////////
-		Controller myController(myInst);
-		ALU_Controller myALU_Control(myInst, myController.ALUOp);
-		int32_t ImmValue = ImmGen(myInst);
-
-		//Register Address 
-		int rd =  (myInst.instr[11] << 4) | (myInst.instr[10] << 3) | (myInst.instr[9] << 2)  |	(myInst.instr[8] << 1)  | (myInst.instr[7]);	
-		int rs1 = (myInst.instr[19] << 4) | (myInst.instr[18] << 3) | (myInst.instr[17] << 2) | (myInst.instr[16] << 1) | (myInst.instr[15]);
-		int rs2 = (myInst.instr[24] << 4) | (myInst.instr[23] << 3) | (myInst.instr[22] << 2) | (myInst.instr[21] << 1) | (myInst.instr[20]);
-
-
-		////////////////
-		// EXECUTION  //
-		////////////////
-
-		//Keeping x0 at 0
-		registers[0] = 0;
-		
-		//Read Registers
-		int rs1Val = registers[rs1];
-		int rs2Val = registers[rs2];
-
-		//KEEP THIS IN CASE OF WRITE DATAPATH
-		int prevRS2 = rs2Val;
-
-		//MUX1 Between RS2 and Imm Gen going into ALU
-		rs2Val = myController.AluSrc ? ImmValue : rs2Val;
-
-		//ALU Operation
-		int32_t ALU_Res = ALU_Result(rs1Val, rs2Val, myALU_Control.ALUOp);
-		bool zeroFlag = ALU_Res ? 0 : 1;
-		
-		//Check on Branch Condition (Changes the next PC to jump)
-		if ((myController.Branch == zeroFlag) && (zeroFlag == 1)) {
-			nextPC = myCPU.readPC() + ImmValue; //Only multiplied by 4 to compensate
-		}
-
-		/////////////////
-		//MEMORY ACCESS//
-		/////////////////
-
-		//If the LOAD/Store
-		bool isWord = false;
-
-		//If we write from memory (LOAD)
-		if (myController.opcode == bitset<7>(0b0000011)) {
-			//LOAD WORD
-			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0x2000)) {
-				isWord = true;
-			}
-			//LOAD BYTE
-			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0b0)) {
-				isWord = false;
-			}
+	SimOptions simOptions;
+	simOptions.detectLoops = detectLoops;
+	if (devices)
+		simOptions.bus = &bus;
+	if (interrupts)
+		simOptions.events = &events;
+	if (logging)
+		simOptions.replay = &replay;
+	ofstream execTrace;
+	if (execTraceFile) {
+		execTrace.open(execTraceFile);
+		if (!execTrace) {
+			cout << "error opening " << execTraceFile << endl;
+			return -1;
 		}
-		//If we write to memory (STORE)
-		else if (myController.opcode == bitset<7>(0b0100011)) {
-			//STORE WORD (32 bits)
-			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0x2000)) {
-				isWord = true;
-			}
-			//STORE BYTE
-			if ((myInst.instr & bitset<32>(0x7000)) == bitset<32>(0b0)) {
-				isWord = false;
-			}
+		simOptions.execTrace = &execTrace;
+	}
+	if (wcet)
+		simOptions.cycleCount = &cycleCount;
+	if (!caches.Empty())
+		simOptions.caches = &caches;
+	if (!branches.Empty())
+		simOptions.branches = &branches;
+	ofstream memTrace;
+	if (!memTraceFile.empty()) {
+		memTrace.open(memTraceFile);
+		if (!memTrace) {
+			cout << "error opening " << memTraceFile << endl;
+			return -1;
 		}
+		simOptions.memTrace = &memTrace;
+	}
+	int registers[32];
+	HostPerf hostPerf;
+	hostPerf.Start();
+	unsigned long long instret = RunProgram(instMem, maxPC, simOptions, registers);
+	hostPerf.Stop();
+	if (perf)
+		hostPerf.Report(cerr, instret);
+	if (!caches.Empty())
+		caches.Report(cerr);
+	if (!branches.Empty())
+		branches.Report(cerr, instret);
+	if (wcet) {
+		cerr << "[WCET] observed " << cycleCount.cycles << " cycles";
+		if (wcetBounded)
+			cerr << (cycleCount.cycles <= wcetBound ? " (within bound)" : " (EXCEEDS BOUND)");
+		cerr << endl;
+	}
 
-		// DATA MEMORY OUTPUT
-		int32_t Read_Data = myCPU.DataMemory(myController.MemWr, myController.MemRe, ALU_Res, prevRS2, isWord);
 
-		//////////////
-		//WRITE BACK//
-		//////////////
-		if (myController.regWrite) {
-			//ADD A condition to Write the next PC if its a JAL
-			if (myController.opcode == bitset<7>(0b1101111)) {
-				registers[rd] = myCPU.readPC() + 4;
-			}
-			else {
-				registers[rd] = myController.MemtoReg ? Read_Data : ALU_Res;
-			}
+	uart.Flush();
+	if (devices && bus.unmapped)
+		cerr << "[MMIO] " << bus.unmapped << " accesses to unmapped device addresses" << endl;
+	if (interrupts)
+		cerr << "[IRQ] " << events.interruptsTaken << " interrupts taken" << endl;
+	if (replay.Diverged())
+		cerr << "[REPLAY] diverged: " << replay.divergence << endl;
+	if (recordFile) {
+		if (!replayLog.Save(recordFile)) {
+			cout << "error writing " << recordFile << endl;
+			return -1;
 		}
-
-
-		//Update PC 
-		myCPU.incPC(nextPC);
-		if (myCPU.readPC() > maxPC)
-			break;
+		cerr << "[RECORD] " << replayLog.events.size() << " events written to " << recordFile << endl;
 	}
 
-
-
 	int a0 = registers[10];
 	int a1 = registers[11];
 	// print the results (you should replace a0 and a1 with your own variables that point to a0 and a1)
 	cout << "(" << a0 << "," << a1 << ")" << endl;
 
-	return 0;
+	//A replay that left the logged path did not reproduce it
+	return replay.Diverged() ? -1 : 0;
 
 }
\ No newline at end of file
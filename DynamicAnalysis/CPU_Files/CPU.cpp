@@ -11,6 +11,30 @@ CPU::CPU()
 	{
 		dmemory[i] = (0);
 	}
+	for (uint64_t& bits : dirtyLines)
+	{
+		bits = 0;
+	}
+}
+
+void CPU::Reset()
+{
+	PC = 0;
+	for (int w = 0; w < 4096 / LINE_WORDS / 64; w++)
+	{
+		//Walk the set bits only, so the cost follows the number of lines touched
+		while (dirtyLines[w] != 0)
+		{
+			int line = w * 64 + __builtin_ctzll(dirtyLines[w]);
+			for (int i = line * LINE_WORDS; i < (line + 1) * LINE_WORDS; i++)
+			{
+				dmemory[i] = 0;
+			}
+			dirtyLines[w] &= dirtyLines[w] - 1;
+		}
+	}
+	errorFlag = false;
+	errorMessage = "";
 }
 
 //Insturction Fetch (Done upon initialization of Instruction object)
@@ -241,11 +265,13 @@ int32_t CPU::DataMemory(int MemWrite, int MemRead, int ALUResult, int rs2, bool
     
     if (MemWrite && word) {
         dmemory[ALUResult / 4] = rs2;
+        MarkDirty(ALUResult / 4);
         return 0;
     }
     //IF the store is just a byte
     else if (MemWrite && !(word) ) {
         dmemory[ALUResult / 4] = rs2 & 0xFF;
+        MarkDirty(ALUResult / 4);
         return 0;
     }
     else if (MemRead && word) {
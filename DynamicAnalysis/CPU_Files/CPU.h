@@ -12,8 +12,14 @@ private:
 	int dmemory[4096]; //data memory byte addressable in little endian fashion;
 	unsigned long PC; //pc 
 
+	//One bit per 16-word (64 byte) line of dmemory written since the last Reset()
+	static const int LINE_WORDS = 16;
+	uint64_t dirtyLines[4096 / LINE_WORDS / 64];
+	void MarkDirty(int index) { if (index >= 0 && index < 4096) dirtyLines[index / (LINE_WORDS * 64)] |= 1ULL << ((index / LINE_WORDS) % 64); }
+
 public:
 	CPU();
+	void Reset(); //same state as a fresh CPU, but only clears the lines that were written
 
 	// SAFETY FOR FUZZING
     bool errorFlag = false;          // True if a crash occurred
@@ -86,8 +86,9 @@ bool judgeState(int registers[], int pc) {
     return true;
 }
 
-void runCPU(vector<unsigned char> &instructions) {
-    CPU myCPU;
+// The CPU is reused between runs; Reset() only clears the memory the last run wrote
+void runCPU(CPU &myCPU, vector<unsigned char> &instructions) {
+    myCPU.Reset();
     const int NUM_REGISTERS = 32;
     int registers[NUM_REGISTERS] = {0};
 
@@ -189,11 +190,18 @@ int main(int argc, char* argv[]) {
     } else if (mode == "file") {
         cout << "Running File-Input Fuzzer (AI Trace)..." << endl;
         if (argc < 3) { cerr << "Provide filename"; return 1; }
-        instructions = loadInstructionsFromFile(argv[2]);
+        // Every trace file given on the command line is run on the same CPU
+        CPU myCPU;
+        for (int f = 2; f < argc; ++f) {
+            instructions = loadInstructionsFromFile(argv[f]);
+            runCPU(myCPU, instructions);
+        }
+        return 0;
     }
 
 
 
-    runCPU(instructions);
+    CPU myCPU;
+    runCPU(myCPU, instructions);
     return 0;
 }
\ No newline at end of file
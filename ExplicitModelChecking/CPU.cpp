@@ -11,12 +11,22 @@ CPU::CPU()
 	{
 		dmemory[i] = (0);
 	}
+	for (int i = 0; i < 32; i++) //registers start at zero (explored states depend on it)
+	{
+		registers[i] = 0;
+	}
 }
 
 //Insturction Fetch (Done upon initialization of Instruction object)
 Instruction::Instruction(unsigned char instructionMem[], CPU cpu)
+    : Instruction(instructionMem, cpu.readPC())
+{
+}
+
+//Fetch without copying the CPU
+Instruction::Instruction(unsigned char instructionMem[], unsigned long pc)
 {
-    unsigned long currentPC = cpu.readPC();
+    unsigned long currentPC = pc;
     //Load the First 
     // Combine the 8 ASCII hex characters into a 32-bit integer
     uint32_t combined = 0;
@@ -53,6 +53,7 @@ class Instruction {
 public:
     bitset<32> instr = 0;
     Instruction(unsigned char instructionMem[], CPU cpu);
+    Instruction(unsigned char instructionMem[], unsigned long pc); // fetch without a CPU copy
 };
 
 class Controller {
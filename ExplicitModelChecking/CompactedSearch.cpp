@@ -0,0 +1,76 @@
+#include "CompactedSearch.h"
+#include "FrontierArena.h"
+#include "Transition.h"
+#include "VisitedTable.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+long long RunCompactedBFS(unsigned char* instMem, int maxPC) {
+    CPU cpu;
+    CompactedTable visited;
+    // The level being expanded and the level being built, each with its arena
+    FrontierArena frontierArena, nextArena;
+    std::vector<FrontierArena::Handle> frontier, next;
+    std::vector<uint16_t> live;
+
+    Fingerprint initial = FingerprintOf(cpu);
+    visited.Insert(initial);
+    std::vector<char> encoded;
+    EncodeState(cpu, encoded);
+    char* at = frontierArena.Begin(initial, encoded.size());
+    memcpy(at, encoded.data(), encoded.size());
+    frontier.push_back(frontierArena.Commit(at + encoded.size()));
+
+    long long states_explored = 0;
+    size_t widest = 0, widestBytes = 0;
+    bool valid_termination_found = false;
+
+    while (!frontier.empty()) {
+        widest = std::max(widest, frontier.size());
+        widestBytes = std::max(widestBytes, frontierArena.Bytes());
+        for (const FrontierArena::Handle& current : frontier) {
+            Fingerprint print = current.Print();
+            DecodeState(current.State(), cpu, live);
+            states_explored++;
+            // LIVENESS CHECK: "finish" means PC goes past the last instruction.
+            if (cpu.PC >= (unsigned long)maxPC * 4) {
+                valid_termination_found = true;
+                continue;
+            }
+            for (int choice = 0, choices = 1; choice < choices; choice++) {
+                StepEffect effect;
+                effect.choice = choice;
+                if (!Step(cpu, instMem, effect, print)) {
+                    ReportViolation(effect, std::cerr);
+                    return states_explored;
+                }
+                choices = effect.choices;
+                if (visited.Insert(print)) {
+                    char* state = nextArena.Begin(print, MAX_ENCODED_STATE);
+                    next.push_back(nextArena.Commit(EncodeState(cpu, live, effect.word, state)));
+                }
+                Undo(cpu, effect, print);
+            }
+        }
+        // The level is done: drop its states in one go
+        frontier.clear();
+        frontierArena.Clear();
+        frontier.swap(next);
+        frontierArena.Swap(nextArena);
+    }
+
+    // --- FINAL REPORT ---
+    if (!valid_termination_found) {
+        std::cout << "[FAIL] Liveness Violation: Program never terminates (Infinite Loop detected)." << std::endl;
+    } else {
+        std::cout << ">>> VERIFICATION SUCCESSFUL! Program terminates safely." << std::endl;
+    }
+    std::cout << "States Explored: " << states_explored << std::endl;
+    std::cout << "Visited Set: " << visited.Size() << " 64-bit keys, " << visited.Bytes() / 1024 << " KB, "
+              << "omission probability " << visited.OmissionProbability() << std::endl;
+    std::cout << "Frontier: widest level " << widest << " states, at most " << widestBytes / 1024
+              << " KB of arena blocks" << std::endl;
+    return states_explored;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////
+// BFS WITH HASH COMPACTION
+//
+// The exact BFS keeps every state it has seen, interned in the state
+// store, only so that the visited set can tell states apart. Here the
+// visited set is a CompactedTable of 64-bit keys, and a state is kept in
+// full only while it waits in the frontier: sparsely encoded, and freed
+// once its level has been expanded. Memory then grows with the widest
+// level rather than with the whole state space.
+//
+// The search is inexact: two states sharing a key count as one, so the
+// second and whatever only it leads to are skipped. The final report
+// gives the probability that this happened anywhere in the run.
+//////////////////////////////////////////////////////////////////////
+
+// Returns the number of states explored
+long long RunCompactedBFS(unsigned char* instMem, int maxPC);
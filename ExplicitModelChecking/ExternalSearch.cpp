@@ -0,0 +1,622 @@
+#include "ExternalSearch.h"
+#include "CPU.h"
+#include "Fingerprint.h"
+#include "Transition.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////
+// ASYNCHRONOUS SEQUENTIAL FILES
+//////////////////////////////////////////////////////////////////////
+
+// Appends to a file. Full blocks go to a background thread that writes
+// them while the caller fills the next one; at most two wait in line.
+class AsyncWriter {
+public:
+    AsyncWriter(const std::string& path, size_t blockBytes) : blockBytes(blockBytes) {
+        file = fopen(path.c_str(), "wb");
+        failed = file == nullptr;
+        block.reserve(blockBytes);
+        io = std::thread(&AsyncWriter::Drain, this);
+    }
+    ~AsyncWriter() { Close(); }
+
+    void Write(const void* data, size_t n) {
+        const char* p = static_cast<const char*>(data);
+        written += n;
+        while (n) {
+            size_t take = std::min(blockBytes - block.size(), n);
+            block.insert(block.end(), p, p + take);
+            p += take;
+            n -= take;
+            if (block.size() == blockBytes) Hand();
+        }
+    }
+
+    // Flushes and closes the file. False if any write failed.
+    bool Close() {
+        if (!io.joinable()) return !failed;
+        if (!block.empty()) Hand();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closing = true;
+        }
+        ready.notify_one();
+        io.join();
+        if (file && fclose(file) != 0) failed = true;
+        file = nullptr;
+        return !failed;
+    }
+
+    uint64_t Bytes() const { return written; }
+
+private:
+    static const size_t MAX_PENDING = 2;
+    size_t blockBytes;
+    FILE* file;
+    bool failed;  // written by the I/O thread, read after it is joined
+    uint64_t written = 0;
+    std::vector<char> block;
+
+    std::thread io;
+    std::mutex lock;
+    std::condition_variable ready;  // a block is pending, or closing
+    std::condition_variable room;   // a pending block was taken
+    std::deque<std::vector<char>> pending;
+    bool closing = false;
+
+    void Hand() {
+        std::unique_lock<std::mutex> guard(lock);
+        room.wait(guard, [this] { return pending.size() < MAX_PENDING; });
+        pending.push_back(std::move(block));
+        guard.unlock();
+        ready.notify_one();
+        block = std::vector<char>();
+        block.reserve(blockBytes);
+    }
+
+    void Drain() {
+        for (;;) {
+            std::unique_lock<std::mutex> guard(lock);
+            ready.wait(guard, [this] { return !pending.empty() || closing; });
+            if (pending.empty()) return;
+            std::vector<char> b = std::move(pending.front());
+            pending.pop_front();
+            guard.unlock();
+            room.notify_one();
+            if (file && fwrite(b.data(), 1, b.size(), file) != b.size()) failed = true;
+        }
+    }
+};
+
+// Reads a file front to back. A background thread keeps up to two blocks
+// read ahead of the caller.
+class AsyncReader {
+public:
+    AsyncReader(const std::string& path, size_t blockBytes) : blockBytes(blockBytes) {
+        file = fopen(path.c_str(), "rb");
+        io = std::thread(&AsyncReader::Fill, this);
+    }
+    ~AsyncReader() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        room.notify_one();
+        io.join();
+        if (file) fclose(file);
+    }
+
+    bool Good() const { return file != nullptr; }
+
+    // Copies the next n bytes. False at the end of the file (or a truncated record).
+    bool Read(void* out, size_t n) {
+        char* p = static_cast<char*>(out);
+        while (n) {
+            if (pos == block.size() && !Next()) return false;
+            size_t take = std::min(block.size() - pos, n);
+            memcpy(p, block.data() + pos, take);
+            pos += take;
+            p += take;
+            n -= take;
+            read += take;
+        }
+        return true;
+    }
+
+    uint64_t Bytes() const { return read; }
+
+private:
+    static const size_t MAX_PENDING = 2;
+    size_t blockBytes;
+    FILE* file;
+    uint64_t read = 0;
+    std::vector<char> block;
+    size_t pos = 0;
+
+    std::thread io;
+    std::mutex lock;
+    std::condition_variable ready;  // a block is pending, or the file ended
+    std::condition_variable room;   // a pending block was taken, or stopping
+    std::deque<std::vector<char>> pending;
+    bool ended = false;
+    bool stopping = false;
+
+    bool Next() {
+        std::unique_lock<std::mutex> guard(lock);
+        ready.wait(guard, [this] { return !pending.empty() || ended; });
+        if (pending.empty()) return false;
+        block = std::move(pending.front());
+        pending.pop_front();
+        pos = 0;
+        guard.unlock();
+        room.notify_one();
+        return true;
+    }
+
+    void Fill() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                room.wait(guard, [this] { return pending.size() < MAX_PENDING || stopping; });
+                if (stopping) return;
+            }
+            std::vector<char> b(blockBytes);
+            size_t n = file ? fread(b.data(), 1, blockBytes, file) : 0;
+            b.resize(n);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (n == 0) ended = true;
+                else pending.push_back(std::move(b));
+            }
+            ready.notify_one();
+            if (n == 0) return;
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+// STATE RECORDS
+//
+// Record: fingerprint lo, hi (8 bytes each), payload length (4), payload.
+// Payload: the state as EncodeState writes it.
+//////////////////////////////////////////////////////////////////////
+
+bool Less(const Fingerprint& a, const Fingerprint& b) {
+    return a.lo != b.lo ? a.lo < b.lo : a.hi < b.hi;
+}
+
+void WritePrint(AsyncWriter& out, const Fingerprint& print) {
+    out.Write(&print.lo, 8);
+    out.Write(&print.hi, 8);
+}
+
+bool ReadPrint(AsyncReader& in, Fingerprint& print) {
+    return in.Read(&print.lo, 8) && in.Read(&print.hi, 8);
+}
+
+void WriteRecord(AsyncWriter& out, const Fingerprint& print, const char* payload, uint32_t length) {
+    WritePrint(out, print);
+    out.Write(&length, 4);
+    out.Write(payload, length);
+}
+
+bool ReadRecord(AsyncReader& in, Fingerprint& print, std::vector<char>& payload) {
+    uint32_t length;
+    if (!ReadPrint(in, print) || !in.Read(&length, 4)) return false;
+    payload.resize(length);
+    return in.Read(payload.data(), length);
+}
+
+// Successors of part of a level. Full buffers are sorted by fingerprint
+// and written as runs of distinct states.
+class RunBuffer {
+public:
+    explicit RunBuffer(size_t bytes) {
+        data.reserve(bytes / 4 * 3);
+        index.reserve(bytes / 4 / sizeof(Entry));
+    }
+
+    // cpu was decoded into live, then stepped, writing word
+    void Add(const Fingerprint& print, const CPU& cpu, const std::vector<uint16_t>& live, int word) {
+        Entry e;
+        e.print = print;
+        e.offset = data.size();
+        EncodeState(cpu, live, word, data);
+        e.length = (uint32_t)(data.size() - e.offset);
+        index.push_back(e);
+    }
+
+    bool Empty() const { return index.empty(); }
+    // Another state might not fit without reallocating
+    bool Full() const { return index.size() == index.capacity() || data.capacity() - data.size() < MAX_RECORD; }
+
+    bool Flush(const std::string& path, size_t blockBytes) {
+        std::sort(index.begin(), index.end(), [](const Entry& a, const Entry& b) { return Less(a.print, b.print); });
+        AsyncWriter out(path, blockBytes);
+        for (size_t i = 0; i < index.size(); i++) {
+            if (i > 0 && index[i].print == index[i - 1].print) continue;
+            WriteRecord(out, index[i].print, &data[index[i].offset], index[i].length);
+        }
+        written += out.Bytes();
+        index.clear();
+        data.clear();
+        return out.Close();
+    }
+
+    uint64_t written = 0;
+
+private:
+    static const size_t MAX_RECORD = 8 + sizeof(CPU::registers) + 6 * 4096;
+    struct Entry {
+        Fingerprint print;
+        uint64_t offset;
+        uint32_t length;
+    };
+    std::vector<char> data;
+    std::vector<Entry> index;
+};
+
+// Reads sorted runs as one sorted stream. Runs overlap, so only the
+// first copy of each fingerprint is returned.
+class RunMerger {
+public:
+    RunMerger(const std::vector<std::string>& paths, size_t blockBytes) : cursors(paths.size()) {
+        for (size_t r = 0; r < paths.size(); r++) {
+            cursors[r].in.reset(new AsyncReader(paths[r], blockBytes));
+            if (!cursors[r].in->Good()) good = false;
+            else Refill((int)r);
+        }
+    }
+
+    bool Good() const { return good; }
+
+    // The next distinct record; payload stays valid until the following call.
+    // False at the end of every run
+    bool Next(Fingerprint& print, const std::vector<char>*& payload) {
+        if (current >= 0) Refill(current);
+        current = -1;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), Later{this});
+            int r = heap.back();
+            heap.pop_back();
+            if (haveLast && cursors[r].print == last) {
+                Refill(r);
+                continue;
+            }
+            last = cursors[r].print;
+            haveLast = true;
+            current = r;
+            print = last;
+            payload = &cursors[r].payload;
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t Bytes() const {
+        uint64_t n = 0;
+        for (const Cursor& c : cursors) n += c.in->Bytes();
+        return n;
+    }
+
+private:
+    struct Cursor {
+        std::unique_ptr<AsyncReader> in;
+        Fingerprint print;
+        std::vector<char> payload;
+    };
+    struct Later {
+        const RunMerger* m;
+        bool operator()(int a, int b) const { return Less(m->cursors[b].print, m->cursors[a].print); }
+    };
+    std::vector<Cursor> cursors;
+    std::vector<int> heap;  // min-heap of cursors by fingerprint
+    bool good = true;
+    int current = -1;       // cursor returned by the last Next
+    Fingerprint last;
+    bool haveLast = false;
+
+    void Refill(int r) {
+        if (!ReadRecord(*cursors[r].in, cursors[r].print, cursors[r].payload)) return;
+        heap.push_back(r);
+        std::push_heap(heap.begin(), heap.end(), Later{this});
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+// SEARCH
+//////////////////////////////////////////////////////////////////////
+
+class ExternalSearch {
+public:
+    ExternalSearch(unsigned char* instMem, int maxPC, const std::string& dir, size_t ramBytes)
+        : instMem(instMem), maxPC(maxPC), dir(dir), ramBytes(ramBytes) {
+        // Identifies the program and its inputs, so a checkpoint is only resumed for the same search
+        uint64_t h = 0xCBF29CE484222325ULL;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 0x100000001B3ULL; };
+        for (int i = 0; i < 4096; i++) mix(instMem[i]);
+        mix((uint64_t)maxPC);
+        for (int v : inputChoices) mix((uint32_t)v);
+        program = h;
+    }
+
+    long long Run(bool resume);
+
+private:
+    static constexpr size_t IO_BLOCK = 1 << 20;
+    static constexpr int MAX_FAN_IN = 32;  // runs one merge opens at once
+
+    unsigned char* instMem;
+    int maxPC;
+    std::string dir;
+    size_t ramBytes;
+    uint64_t program;
+
+    int level = 0;
+    long long explored = 0;
+    bool terminates = false;
+    bool done = false;  // the last level found no new states
+    uint64_t bytesWritten = 0, bytesRead = 0;
+
+    std::string Path(const char* kind, int lvl, int part = -1) const {
+        std::string p = dir + "/" + kind + "-" + std::to_string(lvl);
+        if (part >= 0) p += "-" + std::to_string(part);
+        return p + ".bin";
+    }
+    bool LoadCheckpoint();
+    bool SaveCheckpoint();
+    bool Start();
+    int Expand(int& runs, StepEffect& violation);
+    bool MergeRuns(int first, int end, int into, size_t block);
+    long long Merge(int& runs);
+};
+
+bool ExternalSearch::LoadCheckpoint() {
+    std::ifstream in(dir + "/checkpoint");
+    std::string key;
+    uint64_t savedProgram = 0;
+    int savedLevel = -1;
+    long long savedExplored = 0;
+    int savedTerminates = 0;
+    int savedDone = 0;
+    while (in >> key) {
+        if (key == "program") in >> std::hex >> savedProgram >> std::dec;
+        else if (key == "level") in >> savedLevel;
+        else if (key == "explored") in >> savedExplored;
+        else if (key == "terminates") in >> savedTerminates;
+        else if (key == "done") in >> savedDone;
+    }
+    if (savedLevel < 0) return false;
+    if (savedProgram != program) {
+        std::cerr << "[EXTERNAL] checkpoint in " << dir << " is for another program or inputs, starting over" << std::endl;
+        return false;
+    }
+    level = savedLevel;
+    explored = savedExplored;
+    terminates = savedTerminates != 0;
+    done = savedDone != 0;
+    return true;
+}
+
+// Written to a temporary file and renamed, so a crash leaves the old or the new checkpoint
+bool ExternalSearch::SaveCheckpoint() {
+    std::string tmp = dir + "/checkpoint.tmp";
+    {
+        std::ofstream out(tmp);
+        out << "program " << std::hex << program << std::dec << "\n"
+            << "level " << level << "\n"
+            << "explored " << explored << "\n"
+            << "terminates " << (terminates ? 1 : 0) << "\n"
+            << "done " << (done ? 1 : 0) << "\n";
+        if (!out) return false;
+    }
+    return rename(tmp.c_str(), (dir + "/checkpoint").c_str()) == 0;
+}
+
+// Level 0: the initial state
+bool ExternalSearch::Start() {
+    CPU cpu;
+    Fingerprint print = FingerprintOf(cpu);
+    std::vector<char> payload;
+    EncodeState(cpu, payload);
+    AsyncWriter frontier(Path("frontier", 0), IO_BLOCK);
+    WriteRecord(frontier, print, payload.data(), (uint32_t)payload.size());
+    AsyncWriter visited(Path("visited", 0), IO_BLOCK);
+    WritePrint(visited, print);
+    return frontier.Close() && visited.Close() && SaveCheckpoint();
+}
+
+// Expands every state of the current level into sorted runs.
+// Returns 0, 1 on a safety violation, -1 on an I/O error.
+int ExternalSearch::Expand(int& runs, StepEffect& violation) {
+    AsyncReader frontier(Path("frontier", level), IO_BLOCK);
+    if (!frontier.Good()) return -1;
+    RunBuffer buffer(ramBytes);
+    CPU cpu;
+    std::vector<uint16_t> live;
+    std::vector<char> payload;
+    Fingerprint parent;
+    runs = 0;
+    int result = 0;
+
+    while (result == 0 && ReadRecord(frontier, parent, payload)) {
+        explored++;
+        DecodeState(payload.data(), cpu, live);
+        // LIVENESS CHECK: "finish" means PC goes past the last instruction.
+        if (cpu.PC >= (unsigned long)maxPC * 4) {
+            terminates = true;
+            continue;
+        }
+        for (int choice = 0, choices = 1; choice < choices; choice++) {
+            StepEffect effect;
+            effect.choice = choice;
+            Fingerprint print = parent;
+            if (!Step(cpu, instMem, effect, print)) {
+                violation = effect;
+                result = 1;
+                break;
+            }
+            choices = effect.choices;
+            if (buffer.Full() && !buffer.Flush(Path("run", level, runs++), IO_BLOCK)) {
+                result = -1;
+                break;
+            }
+            buffer.Add(print, cpu, live, effect.word);
+            Undo(cpu, effect, print);
+        }
+    }
+    if (result == 0 && !buffer.Empty() && !buffer.Flush(Path("run", level, runs++), IO_BLOCK)) result = -1;
+    bytesRead += frontier.Bytes();
+    bytesWritten += buffer.written;
+    return result;
+}
+
+// Merges runs [first, end) into run `into` and deletes them.
+bool ExternalSearch::MergeRuns(int first, int end, int into, size_t block) {
+    std::vector<std::string> paths;
+    for (int r = first; r < end; r++) paths.push_back(Path("run", level, r));
+    {
+        RunMerger in(paths, block);
+        if (!in.Good()) return false;
+        AsyncWriter out(Path("run", level, into), block);
+        Fingerprint print;
+        const std::vector<char>* payload;
+        while (in.Next(print, payload)) WriteRecord(out, print, payload->data(), (uint32_t)payload->size());
+        bytesRead += in.Bytes();
+        bytesWritten += out.Bytes();
+        if (!out.Close()) return false;
+    }
+    for (const std::string& path : paths) remove(path.c_str());
+    return true;
+}
+
+// Merges the level's runs against the visited file into the next level
+// and the next visited file. Returns the number of new states, -1 on an I/O error.
+// runs grows by the intermediate runs written, so the caller can delete them all.
+long long ExternalSearch::Merge(int& runs) {
+    // Every open file holds about 3 blocks; split what the RAM budget allows
+    size_t block = std::max<size_t>(4096, std::min<size_t>(IO_BLOCK, ramBytes / (3 * ((size_t)MAX_FAN_IN + 3))));
+
+    // Too many runs to open at once: merge the oldest into a new run until
+    // at most MAX_FAN_IN remain. Each original run is read once before any
+    // merged one is merged again, and the last merge takes only what is
+    // needed to reach MAX_FAN_IN.
+    int first = 0;
+    while (runs - first > MAX_FAN_IN) {
+        int take = std::min(MAX_FAN_IN, runs - first - MAX_FAN_IN + 1);
+        if (!MergeRuns(first, first + take, runs, block)) return -1;
+        first += take;
+        runs++;
+    }
+
+    std::vector<std::string> paths;
+    for (int r = first; r < runs; r++) paths.push_back(Path("run", level, r));
+    RunMerger in(paths, block);
+    if (!in.Good()) return -1;
+    AsyncReader visitedIn(Path("visited", level), block);
+    if (!visitedIn.Good()) return -1;
+    AsyncWriter visitedOut(Path("visited", level + 1), block);
+    AsyncWriter frontierOut(Path("frontier", level + 1), block);
+
+    Fingerprint seen;
+    bool haveSeen = ReadPrint(visitedIn, seen);
+    Fingerprint print;
+    const std::vector<char>* payload;
+    long long fresh = 0;
+    while (in.Next(print, payload)) {
+        while (haveSeen && Less(seen, print)) {
+            WritePrint(visitedOut, seen);
+            haveSeen = ReadPrint(visitedIn, seen);
+        }
+        if (!haveSeen || seen != print) {
+            WritePrint(visitedOut, print);
+            WriteRecord(frontierOut, print, payload->data(), (uint32_t)payload->size());
+            fresh++;
+        }
+    }
+    while (haveSeen) {
+        WritePrint(visitedOut, seen);
+        haveSeen = ReadPrint(visitedIn, seen);
+    }
+
+    bytesRead += visitedIn.Bytes() + in.Bytes();
+    bytesWritten += visitedOut.Bytes() + frontierOut.Bytes();
+    if (!visitedOut.Close() || !frontierOut.Close()) return -1;
+    return fresh;
+}
+
+long long ExternalSearch::Run(bool resume) {
+    if (resume && LoadCheckpoint()) {
+        if (done) std::cerr << "[EXTERNAL] the search in " << dir << " already completed, reporting it" << std::endl;
+        else std::cerr << "[EXTERNAL] resuming at level " << level << " after " << explored << " states" << std::endl;
+    } else if (!Start()) {
+        std::cerr << "Error: cannot write the search files in " << dir << std::endl;
+        return explored;
+    }
+
+    uint64_t visitedStates = 0;
+    while (!done) {
+        int runs;
+        StepEffect violation;
+        int expanded = Expand(runs, violation);
+        if (expanded == 1) {
+            ReportViolation(violation, std::cerr);
+            std::cerr << "Counterexample depth: " << level + 1 << std::endl;
+            for (int r = 0; r < runs; r++) remove(Path("run", level, r).c_str());
+            return explored;
+        }
+        long long fresh = expanded == 0 ? Merge(runs) : -1;
+        if (fresh < 0) {
+            std::cerr << "Error: I/O failure in " << dir << " at level " << level << std::endl;
+            return explored;
+        }
+        for (int r = 0; r < runs; r++) remove(Path("run", level, r).c_str());
+
+        // The next level is complete: record it, then drop the old one.
+        // An empty one ends the search, and a resume finds it done
+        level++;
+        done = fresh == 0;
+        if (!SaveCheckpoint()) {
+            std::cerr << "Error: cannot write the checkpoint in " << dir << std::endl;
+            return explored;
+        }
+        remove(Path("frontier", level - 1).c_str());
+        remove(Path("visited", level - 1).c_str());
+    }
+
+    std::ifstream visited(Path("visited", level), std::ios::binary | std::ios::ate);
+    if (visited) visitedStates = (uint64_t)visited.tellg() / 16;
+
+    // --- FINAL REPORT ---
+    if (!terminates) {
+        std::cout << "[FAIL] Liveness Violation: Program never terminates (Infinite Loop detected)." << std::endl;
+    } else {
+        std::cout << ">>> VERIFICATION SUCCESSFUL! Program terminates safely." << std::endl;
+    }
+    std::cout << "States Explored: " << explored << std::endl;
+    std::cout << "External: " << level << " levels, " << visitedStates << " states visited, "
+              << bytesWritten / (1 << 20) << " MB written, " << bytesRead / (1 << 20) << " MB read this run, RAM budget "
+              << ramBytes / (1 << 20) << " MB" << std::endl;
+    return explored;
+}
+
+}
+
+long long RunExternalBFS(unsigned char* instMem, int maxPC, const std::string& dir, size_t ramBytes, bool resume) {
+    ExternalSearch search(instMem, maxPC, dir, ramBytes);
+    return search.Run(resume);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////
+// EXTERNAL-MEMORY BFS
+//
+// A level-by-level BFS whose frontier and visited set live in files, for
+// state spaces that do not fit in RAM (delayed duplicate detection):
+//   1. Every state of frontier level L is read in order and expanded. Its
+//      successors are collected in a RAM buffer. When the buffer is full,
+//      it is sorted by fingerprint, deduplicated and written out as a run.
+//   2. The runs are merged with each other and with the sorted visited
+//      file. Successors not yet visited become level L + 1, and their
+//      fingerprints join the new visited file. A merge opens at most
+//      32 runs; beyond that, runs are first merged into longer ones.
+//   3. A checkpoint then records the completed level, so a run that stops
+//      can resume from it. It also records when the search has ended.
+// Every file is read and written front to back, and a background thread
+// per file keeps the next block in flight while the search works.
+//
+// States on disk are the PC, the registers and the nonzero memory words.
+// Duplicates are detected by 128-bit fingerprint alone. Two different
+// states sharing one would lose the second, with probability about
+// n^2 / 2^129 for n states.
+//////////////////////////////////////////////////////////////////////
+
+// dir must exist. ramBytes bounds the successor buffer and the I/O blocks.
+// resume continues from dir's checkpoint, if there is one for this program.
+// Returns the number of states explored (in this run and the resumed ones)
+long long RunExternalBFS(unsigned char* instMem, int maxPC, const std::string& dir, size_t ramBytes, bool resume);
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+//////////////////////////////////////////////////////////////////////
+// 128-BIT STATE FINGERPRINTS
+//
+// A state's fingerprint is the XOR of one 128-bit mix per location:
+// location 0 is the PC, 1..32 the registers, and 33 onwards the data
+// memory words. Each mix multiplies the value by an odd per-location key
+// (itself a hash of the location) and then runs a xorshift-multiply
+// finalizer, separately in two 64-bit lanes with different constants.
+// Zero values mix to zero, so an all-zero page adds nothing. Because the
+// mixes are XORed (Zobrist hashing), a write updates the fingerprint in
+// O(1): XOR out the location's old mix and XOR in the new one.
+//
+// MixWords is written as plain lane loops over a block of words so the
+// compiler can vectorize it.
+//////////////////////////////////////////////////////////////////////
+
+struct Fingerprint {
+    uint64_t lo = 0, hi = 0;
+
+    bool operator==(const Fingerprint& other) const { return lo == other.lo && hi == other.hi; }
+    bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+    Fingerprint& operator^=(const Fingerprint& other) { lo ^= other.lo; hi ^= other.hi; return *this; }
+};
+
+namespace FingerprintMix {
+    static const uint32_t PC_LOCATION = 0;
+    static const uint32_t REG_LOCATION = 1;
+    static const uint32_t MEMORY_LOCATION = 33;
+
+    // Odd per-location key. The keys must be unrelated: with keys that are
+    // multiples of one constant, value * key repeats across locations
+    // (PC 24 with x1 = 8 mixed exactly like PC 12 with x1 = 4).
+    inline uint64_t Key(uint32_t location, uint64_t salt) {
+        uint64_t k = (location + salt) * 0x9E3779B97F4A7C15ULL;
+        k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+        return (k ^ (k >> 31)) | 1;
+    }
+
+    inline uint64_t Lo(uint32_t location, uint32_t value) {
+        uint64_t h = (uint64_t)value * Key(location, 0x51ED270B27D4EB4FULL);
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 29;
+        return h;
+    }
+
+    inline uint64_t Hi(uint32_t location, uint32_t value) {
+        uint64_t h = (uint64_t)value * Key(location, 0x2545F4914F6CDD1DULL);
+        h ^= h >> 31;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 30;
+        return h;
+    }
+
+    inline Fingerprint Mix(uint32_t location, uint32_t value) {
+        Fingerprint f;
+        f.lo = Lo(location, value);
+        f.hi = Hi(location, value);
+        return f;
+    }
+
+    // Location changed from oldValue to newValue
+    inline void Swap(Fingerprint& f, uint32_t location, uint32_t oldValue, uint32_t newValue) {
+        if (oldValue == newValue) return;
+        f.lo ^= Lo(location, oldValue) ^ Lo(location, newValue);
+        f.hi ^= Hi(location, oldValue) ^ Hi(location, newValue);
+    }
+
+    // XOR of the mixes of count words stored at locations first, first + 1, ...
+    inline Fingerprint MixWords(uint32_t first, const int* words, int count) {
+        uint64_t lo[4] = { 0, 0, 0, 0 }, hi[4] = { 0, 0, 0, 0 };
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            for (int l = 0; l < 4; l++) {
+                lo[l] ^= Lo(first + i + l, (uint32_t)words[i + l]);
+                hi[l] ^= Hi(first + i + l, (uint32_t)words[i + l]);
+            }
+        }
+        for (; i < count; i++) {
+            lo[0] ^= Lo(first + i, (uint32_t)words[i]);
+            hi[0] ^= Hi(first + i, (uint32_t)words[i]);
+        }
+        Fingerprint f;
+        f.lo = lo[0] ^ lo[1] ^ lo[2] ^ lo[3];
+        f.hi = hi[0] ^ hi[1] ^ hi[2] ^ hi[3];
+        return f;
+    }
+}
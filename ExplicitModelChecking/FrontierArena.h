@@ -0,0 +1,107 @@
+#pragma once
+#include "Fingerprint.h"
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// FRONTIER ARENA
+//
+// Bump allocator for the states of one BFS level. A state is encoded
+// straight into the current block and read back from there in place, so
+// it is written once and never copied: no per-state heap allocation, and
+// no buffer that moves its contents when it grows. A block never moves.
+//
+// Nothing is freed one state at a time. Once the level has been expanded,
+// Clear releases every block but the first in one go, and the first is
+// reused by the next level the arena holds.
+//////////////////////////////////////////////////////////////////////
+
+class FrontierArena {
+public:
+    // A record in the arena: a fingerprint followed by an encoded state.
+    // Move-only, so each record has exactly one owner. It stays valid
+    // until the arena's next Clear.
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        Handle(Handle&& other) noexcept : record(other.record) { other.record = nullptr; }
+        Handle& operator=(Handle&& other) noexcept {
+            record = other.record;
+            other.record = nullptr;
+            return *this;
+        }
+
+        Fingerprint Print() const {
+            Fingerprint print;
+            memcpy(&print, record, sizeof(Fingerprint));
+            return print;
+        }
+        const char* State() const { return record + sizeof(Fingerprint); }
+
+    private:
+        friend class FrontierArena;
+        explicit Handle(const char* record) : record(record) {}
+        const char* record = nullptr;
+    };
+
+    static const size_t BLOCK_BYTES = (size_t)4 << 20;
+
+    FrontierArena() = default;
+    FrontierArena(const FrontierArena&) = delete;
+    FrontierArena& operator=(const FrontierArena&) = delete;
+    ~FrontierArena() {
+        for (char* block : blocks) free(block);
+    }
+
+    // Starts a record: writes print and returns where its state goes,
+    // with room for stateBytes. Finish it with Commit
+    char* Begin(const Fingerprint& print, size_t stateBytes) {
+        size_t bytes = sizeof(Fingerprint) + stateBytes;
+        if (blocks.empty() || used + bytes > BLOCK_BYTES) NewBlock();
+        char* record = blocks.back() + used;
+        memcpy(record, &print, sizeof(Fingerprint));
+        return record + sizeof(Fingerprint);
+    }
+
+    // end is where the state written after Begin stops
+    Handle Commit(const char* end) {
+        char* record = blocks.back() + used;
+        used = end - blocks.back();
+        return Handle(record);
+    }
+
+    // Drops every record at once
+    void Clear() {
+        for (size_t b = 1; b < blocks.size(); b++) free(blocks[b]);
+        blocks.resize(blocks.empty() ? 0 : 1);
+        used = 0;
+    }
+
+    // Handles stay valid: they follow their blocks
+    void Swap(FrontierArena& other) {
+        blocks.swap(other.blocks);
+        std::swap(used, other.used);
+    }
+
+    size_t Bytes() const { return blocks.size() * BLOCK_BYTES; }
+
+private:
+    std::vector<char*> blocks;
+    size_t used = 0;  // bytes taken in the last block
+
+    void NewBlock() {
+        char* block = static_cast<char*>(malloc(BLOCK_BYTES));
+        if (!block) {
+            std::cerr << "Error: out of memory for the BFS frontier" << std::endl;
+            exit(1);
+        }
+        blocks.push_back(block);
+        used = 0;
+    }
+};
@@ -0,0 +1,199 @@
+#include "LayeredSearch.h"
+#include "StateStore.h"
+#include "Transition.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+bool Less(const Fingerprint& a, const Fingerprint& b) {
+    return a.lo != b.lo ? a.lo < b.lo : a.hi < b.hi;
+}
+
+// Sorts states by fingerprint: LSD radix sort on the low word (8-bit
+// digits, skipping digits every key shares), then the rare runs with
+// equal low words are ordered by the high word. Small levels use
+// std::sort, where the radix passes would cost more than they save.
+void SortByPrint(std::vector<QueuedState>& states, std::vector<QueuedState>& scratch) {
+    size_t n = states.size();
+    auto less = [](const QueuedState& a, const QueuedState& b) { return Less(a.print, b.print); };
+    if (n < 256) {
+        std::sort(states.begin(), states.end(), less);
+        return;
+    }
+    scratch.resize(n);
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t count[256] = { 0 };
+        for (const QueuedState& s : states) count[(s.print.lo >> shift) & 0xFF]++;
+        if (count[(states[0].print.lo >> shift) & 0xFF] == n) continue;
+        size_t offset = 0;
+        for (size_t& c : count) {
+            size_t here = c;
+            c = offset;
+            offset += here;
+        }
+        for (const QueuedState& s : states) scratch[count[(s.print.lo >> shift) & 0xFF]++] = s;
+        states.swap(scratch);
+    }
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && states[j].print.lo == states[i].print.lo) j++;
+        if (j - i > 1) std::sort(states.begin() + i, states.begin() + j, less);
+        i = j;
+    }
+}
+
+class SortedVisitedSet {
+public:
+    // states is sorted and free of duplicates. Drops the states already
+    // visited and adds the rest to the set.
+    void Filter(std::vector<QueuedState>& states) {
+        seen.assign(states.size(), 0);
+        for (const Run& run : runs) Mark(run, states);
+        size_t kept = 0;
+        Run fresh;
+        for (size_t i = 0; i < states.size(); i++) {
+            if (seen[i]) continue;
+            fresh.prints.push_back(states[i].print);
+            states[kept++] = states[i];
+        }
+        states.resize(kept);
+        if (fresh.prints.empty()) return;
+        count += fresh.prints.size();
+        runs.push_back(std::move(fresh));
+        // Keep each run more than twice the size of the next: O(log n) runs
+        while (runs.size() >= 2 && runs[runs.size() - 2].prints.size() <= 2 * runs.back().prints.size()) {
+            Run& a = runs[runs.size() - 2];
+            Run& b = runs.back();
+            Run merged;
+            merged.prints.resize(a.prints.size() + b.prints.size());
+            std::merge(a.prints.begin(), a.prints.end(), b.prints.begin(), b.prints.end(), merged.prints.begin(), Less);
+            runs.pop_back();
+            runs.back() = std::move(merged);
+        }
+    }
+
+    size_t Size() const { return count; }
+    size_t Runs() const { return runs.size(); }
+    size_t Bytes() const {
+        size_t bytes = 0;
+        for (const Run& run : runs) bytes += run.prints.capacity() * sizeof(Fingerprint);
+        return bytes;
+    }
+
+private:
+    // A sorted run. Fingerprints are uniform, so an entry's position is
+    // close to lo / 2^64 of the way in: a lookup starts there and gallops
+    // outwards, touching a few nearby blocks instead of binary searching
+    // the whole run.
+    struct Run {
+        std::vector<Fingerprint> prints;
+
+        bool Contains(const Fingerprint& print) const {
+            size_t n = prints.size();
+            if (n == 0) return false;
+            size_t guess = (size_t)(((unsigned __int128)print.lo * n) >> 64);
+            size_t first, last;
+            size_t step = 1;
+            if (Less(prints[guess], print)) {
+                first = guess + 1;
+                while (first + step < n && Less(prints[first + step - 1], print)) {
+                    first += step;
+                    step *= 2;
+                }
+                last = std::min(n, first + step);
+            } else {
+                last = guess + 1;
+                while (last > step && !Less(prints[last - step - 1], print)) {
+                    last -= step;
+                    step *= 2;
+                }
+                first = last > step ? last - step - 1 : 0;
+            }
+            return std::binary_search(prints.begin() + first, prints.begin() + last, print, Less);
+        }
+    };
+    std::vector<Run> runs;  // sizes decreasing
+    std::vector<char> seen;
+    size_t count = 0;
+
+    void Mark(const Run& run, const std::vector<QueuedState>& states) {
+        if (states.size() * 16 < run.prints.size()) {
+            // Few states: look each up
+            for (size_t i = 0; i < states.size(); i++) {
+                if (!seen[i] && run.Contains(states[i].print)) seen[i] = 1;
+            }
+            return;
+        }
+        // One sequential walk over both
+        size_t r = 0;
+        for (size_t i = 0; i < states.size(); i++) {
+            while (r < run.prints.size() && Less(run.prints[r], states[i].print)) r++;
+            if (r < run.prints.size() && run.prints[r] == states[i].print) seen[i] = 1;
+        }
+    }
+};
+
+}
+
+long long RunLayeredBFS(unsigned char* instMem, int maxPC) {
+    Workspace ws;
+    StateStore store;
+    SortedVisitedSet visited;
+    std::vector<QueuedState> frontier, next, scratch;
+
+    QueuedState initial = { store.Intern(ws), FingerprintOf(ws.cpu) };
+    frontier.push_back(initial);
+    visited.Filter(frontier);
+
+    long long states_explored = 0;
+    int levels = 0;
+    bool valid_termination_found = false;
+
+    while (!frontier.empty()) {
+        levels++;
+        next.clear();
+        for (const QueuedState& current : frontier) {
+            states_explored++;
+            // LIVENESS CHECK: "finish" means PC goes past the last instruction.
+            if (current.state.pc >= (uint32_t)maxPC * 4) {
+                valid_termination_found = true;
+                continue;
+            }
+            for (int choice = 0, choices = 1; choice < choices; choice++) {
+                store.Load(current.state, ws);
+                StepEffect effect;
+                effect.choice = choice;
+                Fingerprint print = current.print;
+                if (!Step(ws.cpu, instMem, effect, print)) {
+                    ReportViolation(effect, std::cerr);
+                    return states_explored;
+                }
+                choices = effect.choices;
+                next.push_back({ store.Successor(current.state, ws, effect), print });
+            }
+        }
+
+        // Dedup the level: sort, drop adjacent repeats, drop the visited
+        SortByPrint(next, scratch);
+        next.erase(std::unique(next.begin(), next.end(),
+                               [](const QueuedState& a, const QueuedState& b) { return a.print == b.print; }),
+                   next.end());
+        visited.Filter(next);
+        frontier.swap(next);
+    }
+
+    // --- FINAL REPORT ---
+    if (!valid_termination_found) {
+        std::cout << "[FAIL] Liveness Violation: Program never terminates (Infinite Loop detected)." << std::endl;
+    } else {
+        std::cout << ">>> VERIFICATION SUCCESSFUL! Program terminates safely." << std::endl;
+    }
+    std::cout << "States Explored: " << states_explored << std::endl;
+    store.Report(std::cout, visited.Size());
+    std::cout << "Visited Set: " << visited.Size() << " fingerprints in " << visited.Runs() << " sorted runs, "
+              << visited.Bytes() / 1024 << " KB, " << levels << " levels" << std::endl;
+    return states_explored;
+}
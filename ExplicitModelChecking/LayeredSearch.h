@@ -0,0 +1,23 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////
+// LAYERED BFS WITH SORT-BASED DUPLICATE DETECTION
+//
+// Instead of probing a hash table once per successor, a whole level's
+// successors are collected in a flat array and radix-sorted by
+// fingerprint. Duplicates within the level are then adjacent, and the
+// sorted level is checked against the sorted visited set by walking both
+// in order. Every pass is sequential, so the search does no random probes.
+//
+// The visited set is a few sorted runs of fingerprints whose sizes grow
+// geometrically: each level's new fingerprints are added as a run, and
+// runs of similar size are merged. A level much smaller than a run is
+// looked up one state at a time instead of walked, so long chains of
+// one-state levels do not rescan the whole set each time.
+//
+// Like the external search, duplicates are detected by 128-bit
+// fingerprint alone.
+//////////////////////////////////////////////////////////////////////
+
+// Returns the number of states explored
+long long RunLayeredBFS(unsigned char* instMem, int maxPC);
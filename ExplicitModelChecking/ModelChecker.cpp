@@ -1,134 +1,257 @@
 #include "CPU.h"
+#include "CompactedSearch.h"
+#include "ExternalSearch.h"
+#include "HostPerf.h"
+#include "LayeredSearch.h"
+#include "ParallelSearch.h"
+#include "StateStore.h"
+#include "Fingerprint.h"
+#include "Transition.h"
+#include "VisitedTable.h"
 #include <iostream>
 #include <vector>
 #include <queue>
-#include <unordered_set>
 #include <fstream>
 #include <sstream>
 
-// Custom Hash Function for StateSnapshot
-struct StateHash {
-    size_t operator()(const CPU::StateSnapshot& s) const {
-        size_t h1 = std::hash<unsigned long>{}(s.pc);
-        size_t h2 = 0;
-        for (int i = 0; i < 32; i++) {
-            h2 ^= std::hash<int>{}(s.regs[i]) + 0x9e3779b9 + (h2 << 6) + (h2 >> 2);
-        }
-        // Hashing memory (simplified to first 100 words for performance, can hash all 4096 for correctness)
-        for (int i = 0; i < 100; i++) {
-             h2 ^= std::hash<int>{}(s.memory[i]) + 0x9e3779b9 + (h2 << 6) + (h2 >> 2);
-        }
-        return h1 ^ (h2 << 1);
-    }
-};
-
-// --- PROPERTY CHECKER ---
-bool VerifyState(CPU& cpu, Instruction& instr, Controller& ctrl, int32_t alu_res) {
-    // 1. SAFETY: Memory Bounds & Alignment
-    if (ctrl.MemRe || ctrl.MemWr) {
-        if (alu_res < 0 || alu_res >= 4096 * 4) {
-            std::cerr << "[FAIL] Memory Access Out of Bounds. PC: " << cpu.readPC() << " Addr: " << alu_res << std::endl;
-            return false;
-        }
-        bool isWord = ((instr.instr.to_ulong() & 0x7000) == 0x2000); 
-        if (isWord && (alu_res % 4 != 0)) {
-            std::cerr << "[FAIL] Misaligned Word Access. PC: " << cpu.readPC() << " Addr: " << alu_res << std::endl;
-            return false;
-        }
-    }
-    // 2. INVARIANT: x0 is always 0
-    if (cpu.registers[0] != 0) {
-        std::cerr << "[FAIL] Register x0 corruption. PC: " << cpu.readPC() << std::endl;
-        return false;
-    }
-    return true;
-}
-
-
 // --- BFS SEARCH (with Liveness Check) ---
-void RunBFS(unsigned char* instMem, int maxPC) {
-    CPU myCPU;
-    std::queue<CPU::StateSnapshot> q;
-    std::unordered_set<CPU::StateSnapshot, StateHash> visited;
+// States live in a hash-consed StateStore: the queue and the visited set
+// hold 24-byte CompactStates instead of 16 KB snapshots. The visited set
+// is keyed by the full-state fingerprint, which each step updates in O(1)
+// from its parent's. A read of the input port has one successor per
+// value in inputChoices.
+// Returns the number of states explored
+long long RunBFS(unsigned char* instMem, int maxPC) {
+    Workspace ws;
+    StateStore store;
+    std::queue<QueuedState> q;
+    VisitedTable visited;
 
-    CPU::StateSnapshot initial = myCPU.GetState();
+    QueuedState initial = { store.Intern(ws), FingerprintOf(ws.cpu) };
     q.push(initial);
-    visited.insert(initial);
+    visited.Insert(initial.print, initial.state);
 
-    int states_explored = 0;
+    long long states_explored = 0;
     bool valid_termination_found = false; // <--- NEW TRACKER
 
     while (!q.empty()) {
-        CPU::StateSnapshot current_snap = q.front();
+        CompactState current = q.front().state;
+        Fingerprint print = q.front().print;
         q.pop();
         states_explored++;
 
-        myCPU.RestoreState(current_snap);
-        unsigned long pc = myCPU.readPC();
-
         // LIVENESS CHECK: Did we successfully finish the program?
         // In this sim, "finish" means PC goes past the last instruction.
-        if (pc >= maxPC * 4) {
+        if (current.pc >= (uint32_t)maxPC * 4) {
             valid_termination_found = true; 
             continue; // Stop exploring this path, it succeeded.
         }
 
-        Instruction myInst(instMem, myCPU);
-        unsigned long nextPC = pc + 4;
-
-        Controller myController(myInst);
-        ALU_Controller myALU_Control(myInst, myController.ALUOp);
-        int32_t ImmValue = ImmGen(myInst);
-
-        // ... (Register Decoding & Execution Logic remains same) ...
-        int rs1 = (myInst.instr.to_ulong() >> 15) & 0x1F;
-        int rs2 = (myInst.instr.to_ulong() >> 20) & 0x1F;
-        int rd = (myInst.instr.to_ulong() >> 7) & 0x1F;
-        myCPU.registers[0] = 0;
-        int rs1Val = myCPU.registers[rs1];
-        int rs2Val = myCPU.registers[rs2];
-        int rs2Val_mux = myController.AluSrc ? ImmValue : rs2Val;
-        int32_t ALU_Res = ALU_Result(rs1Val, rs2Val_mux, myALU_Control.ALUOp);
-        
-        // Safety Property Verification
-        if (!VerifyState(myCPU, myInst, myController, ALU_Res)) return;
-
-        // ... (Memory & Writeback Logic remains same) ...
-        bool zeroFlag = (ALU_Res == 0);
-        if (myController.Branch && zeroFlag) nextPC = pc + ImmValue;
-        bool isWord = ((myInst.instr.to_ulong() & 0x7000) == 0x2000);
-        int32_t Read_Data = myCPU.DataMemory(myController.MemWr, myController.MemRe, ALU_Res, rs2Val, isWord);
-        if (myController.regWrite && rd != 0) {
-            if (myController.opcode == 0x6F) myCPU.registers[rd] = pc + 4;
-            else myCPU.registers[rd] = myController.MemtoReg ? Read_Data : ALU_Res;
+        for (int choice = 0, choices = 1; choice < choices; choice++) {
+            store.Load(current, ws);
+            StepEffect effect;
+            effect.choice = choice;
+            Fingerprint next_print = print;
+            if (!Step(ws.cpu, instMem, effect, next_print)) {
+                ReportViolation(effect, std::cerr);
+                return states_explored;
+            }
+            choices = effect.choices;
+
+            // Add next state to queue
+            CompactState next_state = store.Successor(current, ws, effect);
+            if (visited.Insert(next_print, next_state)) {
+                q.push({ next_state, next_print });
+            }
+        }
+    }
+
+    // --- FINAL REPORT ---
+    if (!valid_termination_found) {
+        std::cout << "[FAIL] Liveness Violation: Program never terminates (Infinite Loop detected)." << std::endl;
+    } else {
+        std::cout << ">>> VERIFICATION SUCCESSFUL! Program terminates safely." << std::endl;
+    }
+    std::cout << "States Explored: " << states_explored << std::endl;
+    store.Report(std::cout, visited.Size());
+    std::cout << "Visited Set: " << visited.Size() << " states, " << visited.Bytes() / 1024 << " KB, "
+              << visited.fullCompares << " full compares, " << visited.collisions << " fingerprint collisions" << std::endl;
+    return states_explored;
+}
+
+// --- DFS SEARCH (with Liveness Check) ---
+// One live CPU walks the state graph. Each step's StepEffect is its undo
+// record (old PC, register and memory word), so backtracking applies it
+// instead of restoring a snapshot, and the stack costs about 100 bytes per
+// level of depth. States are still interned, but only to key the exact
+// visited set; the search never loads one back. With a bitstate table
+// nothing is interned at all: memory is the bit array plus the stack.
+// Returns the number of states explored
+struct DfsFrame {
+    CompactState state;
+    Fingerprint print;
+    int choice;       // next input value to try
+    int choices;      // known once the first successor is stepped
+    StepEffect undo;  // the step to the child being explored
+};
+
+long long RunDFS(unsigned char* instMem, int maxPC, BitstateTable* bitstate) {
+    Workspace ws;
+    CPU& cpu = ws.cpu;
+    StateStore store;
+    VisitedTable visited;
+    std::vector<DfsFrame> stack;
+
+    DfsFrame root = { CompactState(), FingerprintOf(cpu), 0, 1, StepEffect() };
+    if (bitstate) {
+        root.state.pc = (uint32_t)cpu.PC;
+        bitstate->Insert(root.print);
+    } else {
+        root.state = store.Intern(ws);
+        visited.Insert(root.print, root.state);
+    }
+    long long states_explored = 1;
+    size_t max_depth = 0;
+    bool valid_termination_found = root.state.pc >= (uint32_t)maxPC * 4;
+    if (!valid_termination_found) stack.push_back(root);
+
+    while (!stack.empty()) {
+        DfsFrame& top = stack.back();
+        if (top.choice == top.choices) {
+            // Backtrack: the parent's undo record takes the CPU back to the parent
+            stack.pop_back();
+            if (!stack.empty()) {
+                Fingerprint print = stack.back().print; // already known, Undo's update is not needed
+                Undo(cpu, stack.back().undo, print);
+            }
+            continue;
         }
 
-        myCPU.incPC(nextPC);
+        StepEffect effect;
+        effect.choice = top.choice;
+        Fingerprint print = top.print;
+        if (!Step(cpu, instMem, effect, print)) {
+            ReportViolation(effect, std::cerr);
+            std::cerr << "Counterexample depth: " << stack.size() << std::endl;
+            return states_explored;
+        }
+        top.choices = effect.choices;
+        top.choice++;
 
-        // Add next state to queue
-        CPU::StateSnapshot next_state = myCPU.GetState();
-        if (visited.find(next_state) == visited.end()) {
-            visited.insert(next_state);
-            q.push(next_state);
+        CompactState next_state;
+        bool fresh;
+        if (bitstate) {
+            next_state.pc = (uint32_t)cpu.PC;  // the rest is never read
+            fresh = bitstate->Insert(print);
+        } else {
+            next_state = store.Successor(top.state, ws, effect);
+            fresh = visited.Insert(print, next_state);
+        }
+        if (!fresh) {
+            Undo(cpu, effect, print);
+            continue;
         }
+        states_explored++;
+        // LIVENESS CHECK: a path past the last instruction is not explored further
+        if (next_state.pc >= (uint32_t)maxPC * 4) {
+            valid_termination_found = true;
+            Undo(cpu, effect, print);
+            continue;
+        }
+        top.undo = effect;
+        stack.push_back({ next_state, print, 0, 1, StepEffect() });
+        if (stack.size() > max_depth) max_depth = stack.size();
     }
 
     // --- FINAL REPORT ---
     if (!valid_termination_found) {
         std::cout << "[FAIL] Liveness Violation: Program never terminates (Infinite Loop detected)." << std::endl;
+        if (bitstate) std::cout << "       (bitstate search: the terminating path may have been omitted, see below)" << std::endl;
     } else {
         std::cout << ">>> VERIFICATION SUCCESSFUL! Program terminates safely." << std::endl;
     }
     std::cout << "States Explored: " << states_explored << std::endl;
+    if (bitstate) {
+        std::cout << "Bitstate: " << bitstate->Bytes() / 1024 << " KB, fill " << bitstate->Fill() * 100
+                  << "%, ~" << (long long)(bitstate->DirectCollisions() + 0.5)
+                  << " direct hash collisions (a lower bound on omitted states: what only they lead to is lost too)" << std::endl;
+        if (bitstate->Overfilled()) {
+            std::cout << "[WARN] Bitstate array more than 1/K full: many states are likely omitted. "
+                      << "Rerun with a larger --bitstate." << std::endl;
+        }
+    } else {
+        store.Report(std::cout, visited.Size());
+        std::cout << "Visited Set: " << visited.Size() << " states, " << visited.Bytes() / 1024 << " KB, "
+                  << visited.fullCompares << " full compares, " << visited.collisions << " fingerprint collisions" << std::endl;
+    }
+    std::cout << "DFS Stack: max depth " << max_depth << ", " << max_depth * sizeof(DfsFrame) / 1024 << " KB" << std::endl;
+    return states_explored;
+}
+
+// "3,-1,0x10" -> {3, -1, 16}
+static bool ParseInputs(const std::string& list, std::vector<int>& values) {
+    std::stringstream fields(list);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        try {
+            values.push_back((int)std::stol(field, nullptr, 0));
+        } catch (...) {
+            return false;
+        }
+    }
+    return !values.empty();
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: ./modelchecker <instruction_file>" << std::endl;
+    // Options: --perf            report host counters per explored state (stderr)
+    //          --dfs             depth-first search with undo records instead of BFS
+    //          --bitstate MB     depth-first search with an MB megabyte bitstate visited set (inexact)
+    //          --hashes K        bits set per state in bitstate mode (default 3)
+    //          --layered         BFS with sort-based duplicate detection per level
+    //          --compact         BFS with a hash-compaction visited set of 64-bit keys (inexact)
+    //          --external DIR    BFS with the frontier and visited set in files under DIR
+    //          --ram MB          external BFS: RAM budget (default 1024)
+    //          --resume          external BFS: continue from DIR's last completed level
+    //          --inputs a,b,...  reads of the input port (0x4000) return each value in turn
+    //          --threads N       parallel search on N threads (0 = all hardware threads)
+    //          --table-bits B    parallel search: 2^B slots per table (default 22)
+    bool perf = false;
+    bool dfs = false;
+    size_t bitstateMB = 0;
+    int hashes = 3;
+    const char* externalDir = nullptr;
+    size_t ramMB = 1024;
+    bool resume = false;
+    bool layered = false;
+    bool compact = false;
+    int threads = -1;
+    unsigned tableBits = 22;
+    const char* fileName = nullptr;
+    bool usage = false;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--perf") perf = true;
+        else if (arg == "--dfs") dfs = true;
+        else if (arg == "--bitstate" && a + 1 < argc) { bitstateMB = (size_t)atol(argv[++a]); dfs = true; usage |= bitstateMB == 0; }
+        else if (arg == "--hashes" && a + 1 < argc) hashes = atoi(argv[++a]);
+        else if (arg == "--external" && a + 1 < argc) externalDir = argv[++a];
+        else if (arg == "--ram" && a + 1 < argc) ramMB = (size_t)atol(argv[++a]);
+        else if (arg == "--resume") resume = true;
+        else if (arg == "--layered") layered = true;
+        else if (arg == "--compact") compact = true;
+        else if (arg == "--inputs" && a + 1 < argc) usage |= !ParseInputs(argv[++a], inputChoices);
+        else if (arg == "--threads" && a + 1 < argc) threads = atoi(argv[++a]);
+        else if (arg == "--table-bits" && a + 1 < argc) tableBits = (unsigned)atoi(argv[++a]);
+        else fileName = argv[a];
+    }
+    if (tableBits < 10 || tableBits > 30 || hashes < 1 || ramMB < 1) usage = true;
+    if ((dfs ? 1 : 0) + (threads >= 0 ? 1 : 0) + (externalDir ? 1 : 0) + (layered ? 1 : 0) + (compact ? 1 : 0) > 1) usage = true; // one search at a time
+    if (fileName == nullptr || usage) {
+        std::cout << "Usage: ./modelchecker [--perf] [--dfs] [--bitstate MB [--hashes K]] [--inputs a,b,...] [--threads N] [--table-bits B] [--layered] [--compact] [--external DIR [--ram MB] [--resume]] <instruction_file>" << std::endl;
         return -1;
     }
     unsigned char instMem[4096] = {0};
-    std::ifstream infile(argv[1]);
+    std::ifstream infile(fileName);
     if (!infile.is_open()) { std::cout << "Error opening file\n"; return 0; }
 
     std::string line;
@@ -140,6 +263,20 @@ int main(int argc, char* argv[]) {
         instMem[i] = static_cast<char>(hexValue);
         i++;
     }
-    RunBFS(instMem, i / 4); // Pass roughly instruction count
+    HostPerf hostPerf;
+    hostPerf.Start();
+    long long states; // maxPC: pass roughly instruction count
+    if (externalDir) states = RunExternalBFS(instMem, i / 4, externalDir, ramMB << 20, resume);
+    else if (threads >= 0) states = RunParallelBFS(instMem, i / 4, threads, tableBits);
+    else if (bitstateMB) {
+        BitstateTable bitstate(bitstateMB << 20, hashes);
+        states = RunDFS(instMem, i / 4, &bitstate);
+    }
+    else if (dfs) states = RunDFS(instMem, i / 4, nullptr);
+    else if (layered) states = RunLayeredBFS(instMem, i / 4);
+    else if (compact) states = RunCompactedBFS(instMem, i / 4);
+    else states = RunBFS(instMem, i / 4);
+    hostPerf.Stop();
+    if (perf) hostPerf.Report(std::cerr, states, "state");
     return 0;
 }
@@ -0,0 +1,248 @@
+#include "ParallelSearch.h"
+#include "StateStore.h"
+#include "Transition.h"
+#include "VisitedTable.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct alignas(64) WorkQueue {
+    std::mutex lock;
+    std::deque<QueuedState> items;
+    std::atomic<size_t> size{0};  // for peeking without the lock
+};
+
+struct alignas(64) WorkerStats {
+    long long explored = 0;
+    long long steals = 0;
+    ConcurrentVisitedTable::Counters visited;
+};
+
+class ParallelSearch {
+public:
+    ParallelSearch(unsigned char* instMem, int maxPC, int threads, unsigned logSlots)
+        : instMem(instMem), maxPC(maxPC), threads(threads), store(logSlots), visited(logSlots),
+          queues(threads), stats(threads) {}
+
+    long long Run();
+
+private:
+    // How often (in states) a thread publishes its insert count and checks the tables for room.
+    // Between checks, the tables' probe limits catch a table that fills up
+    static const int CHECK_INTERVAL = 1024;
+
+    unsigned char* instMem;
+    int maxPC;
+    int threads;
+    SharedStateStore store;
+    ConcurrentVisitedTable visited;
+    std::vector<WorkQueue> queues;
+    std::vector<WorkerStats> stats;
+
+    std::atomic<int> idle{0};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> terminates{false};   // some path ran past the last instruction
+    std::atomic<unsigned long long> inserted{0};
+
+    std::mutex failLock;                   // guards the first reason to stop
+    bool violated = false;
+    bool full = false;
+    StepEffect violation;
+
+    void Worker(int id);
+    bool Pop(int id, QueuedState& out);
+    bool Steal(int id, QueuedState& out, unsigned& seed);
+    void Expand(int id, const QueuedState& item, Workspace& ws, std::vector<QueuedState>& fresh);
+    void Fail(const StepEffect* effect);
+};
+
+bool ParallelSearch::Pop(int id, QueuedState& out)
+{
+    WorkQueue& q = queues[id];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.items.empty()) return false;
+    out = q.items.front();
+    q.items.pop_front();
+    q.size.store(q.items.size(), std::memory_order_relaxed);
+    return true;
+}
+
+// Called while counted idle. Leaves the idle count only to take work that
+// some deque was seen to hold, so idle == threads really means no work left.
+bool ParallelSearch::Steal(int id, QueuedState& out, unsigned& seed)
+{
+    for (int attempt = 0; attempt < threads; attempt++) {
+        seed = seed * 1103515245u + 12345u;
+        int victim = (int)((seed >> 8) % (unsigned)threads);
+        if (victim == id || queues[victim].size.load(std::memory_order_relaxed) == 0) continue;
+
+        idle.fetch_sub(1);
+        std::vector<QueuedState> taken;
+        {
+            WorkQueue& v = queues[victim];
+            std::lock_guard<std::mutex> guard(v.lock);
+            size_t n = (v.items.size() + 1) / 2;
+            taken.assign(v.items.end() - n, v.items.end());
+            v.items.erase(v.items.end() - n, v.items.end());
+            v.size.store(v.items.size(), std::memory_order_relaxed);
+        }
+        if (taken.empty()) {
+            idle.fetch_add(1);
+            continue;
+        }
+        stats[id].steals++;
+        out = taken.front();
+        if (taken.size() > 1) {
+            WorkQueue& q = queues[id];
+            std::lock_guard<std::mutex> guard(q.lock);
+            q.items.insert(q.items.end(), taken.begin() + 1, taken.end());
+            q.size.store(q.items.size(), std::memory_order_relaxed);
+        }
+        return true;
+    }
+    return false;
+}
+
+void ParallelSearch::Fail(const StepEffect* effect)
+{
+    std::lock_guard<std::mutex> guard(failLock);
+    if (!violated && !full) {
+        if (effect) {
+            violated = true;
+            violation = *effect;
+        } else {
+            full = true;
+        }
+    }
+    stop.store(true);
+}
+
+void ParallelSearch::Expand(int id, const QueuedState& item, Workspace& ws, std::vector<QueuedState>& fresh)
+{
+    // LIVENESS CHECK: "finish" means PC goes past the last instruction.
+    if (item.state.pc >= (uint32_t)maxPC * 4) {
+        if (!terminates.load(std::memory_order_relaxed)) terminates.store(true);
+        return;
+    }
+    for (int choice = 0, choices = 1; choice < choices; choice++) {
+        store.Load(item.state, ws);
+        StepEffect effect;
+        effect.choice = choice;
+        Fingerprint print = item.print;
+        if (!Step(ws.cpu, instMem, effect, print)) {
+            Fail(&effect);
+            return;
+        }
+        choices = effect.choices;
+        CompactState next = store.Successor(item.state, ws, effect);
+        bool isNew = !store.Overflowed() && visited.Insert(print, next, stats[id].visited);
+        if (store.Overflowed() || visited.Overflowed()) {
+            // A table filled up before the periodic check caught it
+            Fail(nullptr);
+            return;
+        }
+        if (isNew) fresh.push_back({ next, print });
+    }
+}
+
+void ParallelSearch::Worker(int id)
+{
+    Workspace ws;
+    WorkerStats& mine = stats[id];
+    std::vector<QueuedState> fresh;
+    unsigned seed = 0x9E3779B9u * (id + 1);
+    unsigned long long published = 0;
+    QueuedState item;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (!Pop(id, item)) {
+            idle.fetch_add(1);
+            bool found = false;
+            while (!found && !stop.load(std::memory_order_relaxed) && idle.load() < threads) {
+                found = Steal(id, item, seed);
+                if (!found) std::this_thread::yield();
+            }
+            if (!found) break;  // stays counted idle, so the others see the end too
+        }
+
+        mine.explored++;
+        fresh.clear();
+        Expand(id, item, ws, fresh);
+        if (!fresh.empty()) {
+            WorkQueue& q = queues[id];
+            std::lock_guard<std::mutex> guard(q.lock);
+            q.items.insert(q.items.end(), fresh.begin(), fresh.end());
+            q.size.store(q.items.size(), std::memory_order_relaxed);
+        }
+
+        if (mine.explored % CHECK_INTERVAL == 0) {
+            unsigned long long total = inserted.fetch_add(mine.visited.inserted - published) + mine.visited.inserted - published;
+            published = mine.visited.inserted;
+            if (total * 4 > visited.Capacity() * 3 || store.Full()) Fail(nullptr);
+        }
+    }
+}
+
+long long ParallelSearch::Run()
+{
+    Workspace ws;
+    ConcurrentVisitedTable::Counters initialCounters;
+    QueuedState initial = { store.Intern(ws), FingerprintOf(ws.cpu) };
+    visited.Insert(initial.print, initial.state, initialCounters);
+    queues[0].items.push_back(initial);
+    queues[0].size.store(1);
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(&ParallelSearch::Worker, this, t);
+    for (std::thread& t : pool) t.join();
+
+    long long states_explored = 0, steals = 0;
+    ConcurrentVisitedTable::Counters total = initialCounters;
+    for (const WorkerStats& s : stats) {
+        states_explored += s.explored;
+        steals += s.steals;
+        total.inserted += s.visited.inserted;
+        total.fullCompares += s.visited.fullCompares;
+        total.collisions += s.visited.collisions;
+    }
+
+    if (violated) {
+        ReportViolation(violation, std::cerr);
+        return states_explored;
+    }
+    if (full) {
+        std::cerr << "Error: state tables full after " << total.inserted
+                  << " states; rerun with a larger --table-bits" << std::endl;
+        return states_explored;
+    }
+
+    // --- FINAL REPORT ---
+    if (!terminates) {
+        std::cout << "[FAIL] Liveness Violation: Program never terminates (Infinite Loop detected)." << std::endl;
+    } else {
+        std::cout << ">>> VERIFICATION SUCCESSFUL! Program terminates safely." << std::endl;
+    }
+    std::cout << "States Explored: " << states_explored << std::endl;
+    store.Report(std::cout, total.inserted);
+    std::cout << "Visited Set: " << total.inserted << " states, " << total.inserted * visited.EntryBytes() / 1024 << " KB used, "
+              << visited.Bytes() / 1024 << " KB reserved, "
+              << total.fullCompares << " full compares, " << total.collisions << " fingerprint collisions" << std::endl;
+    std::cout << "Parallel: " << threads << " threads, " << steals << " steals" << std::endl;
+    return states_explored;
+}
+
+}
+
+long long RunParallelBFS(unsigned char* instMem, int maxPC, int threads, unsigned logSlots)
+{
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::unique_ptr<ParallelSearch> search(new ParallelSearch(instMem, maxPC, threads, logSlots));
+    return search->Run();
+}
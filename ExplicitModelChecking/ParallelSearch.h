@@ -0,0 +1,28 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////
+// PARALLEL SEARCH
+//
+// The same search as RunBFS, spread over threads. All threads share one
+// SharedStateStore and one ConcurrentVisitedTable, both lock-free. Each
+// thread has its own frontier deque: it takes work from the front and
+// pushes the new successors to the back. A thread whose deque is empty
+// steals half of another thread's deque, from the back.
+//
+// Termination: a thread that finds no work anywhere counts itself idle,
+// and stops being idle only to take items it has seen in some deque. Only
+// a busy thread can push items, so once every thread is idle all deques
+// are empty and stay empty, and the search is over.
+//
+// A violation, or the fixed-size tables filling up, raises a stop flag
+// that every thread checks before each state.
+//
+// Within a deque the order is FIFO, but across threads it is not level by
+// level, so a parallel run can report a different violation than the
+// sequential BFS when a program has several. Without violations it
+// explores exactly the same states.
+//////////////////////////////////////////////////////////////////////
+
+// threads 0 uses one per hardware thread. The tables get 2^logSlots slots.
+// Returns the number of states explored
+long long RunParallelBFS(unsigned char* instMem, int maxPC, int threads, unsigned logSlots);
@@ -0,0 +1,222 @@
+#include "StateStore.h"
+#include <cstdlib>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////
+// INTERN TABLE
+//////////////////////////////////////////////////////////////////////
+
+template <int WORDS>
+static uint32_t InternHash(const uint32_t* words)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < WORDS; i++) {
+        h = (h ^ words[i]) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+template <int WORDS>
+void InternTable<WORDS>::Grow()
+{
+    std::vector<uint32_t> bigger(slots.size() * 2, EMPTY);
+    size_t mask = bigger.size() - 1;
+    for (uint32_t id = 0; id < hashes.size(); id++) {
+        size_t s = hashes[id] & mask;
+        while (bigger[s] != EMPTY) s = (s + 1) & mask;
+        bigger[s] = id;
+    }
+    slots.swap(bigger);
+}
+
+template <int WORDS>
+uint32_t InternTable<WORDS>::Intern(const uint32_t* words)
+{
+    uint32_t h = InternHash<WORDS>(words);
+    size_t mask = slots.size() - 1;
+    size_t s = h & mask;
+    for (; slots[s] != EMPTY; s = (s + 1) & mask) {
+        uint32_t id = slots[s];
+        if (hashes[id] == h && memcmp(Get(id), words, WORDS * 4) == 0) return id;
+    }
+    uint32_t id = (uint32_t)hashes.size();
+    data.insert(data.end(), words, words + WORDS);
+    hashes.push_back(h);
+    slots[s] = id;
+    if (hashes.size() * 2 > slots.size()) Grow(); // keep the load factor under 1/2
+    return id;
+}
+
+//////////////////////////////////////////////////////////////////////
+// CONCURRENT INTERN TABLE
+//////////////////////////////////////////////////////////////////////
+
+template <int WORDS>
+ConcurrentInternTable<WORDS>::ConcurrentInternTable(unsigned logSlots)
+{
+    // calloc'd, so untouched parts of the index cost no memory
+    mask = ((size_t)1 << logSlots) - 1;
+    slots = static_cast<std::atomic<uint64_t>*>(calloc(mask + 1, sizeof(std::atomic<uint64_t>)));
+    // Room for twice as many IDs as slots, which covers those claimed but unused
+    numChunks = ((mask + 1) * 2 >> CHUNK_BITS) + 1;
+    chunks = static_cast<std::atomic<uint32_t*>*>(calloc(numChunks, sizeof(std::atomic<uint32_t*>)));
+    if (!slots || !chunks) {
+        std::cerr << "Error: cannot allocate a 2^" << logSlots << " slot intern table" << std::endl;
+        exit(1);
+    }
+}
+
+template <int WORDS>
+ConcurrentInternTable<WORDS>::~ConcurrentInternTable()
+{
+    for (size_t c = 0; c < numChunks; c++) delete[] chunks[c].load();
+    free(chunks);
+    free(slots);
+}
+
+template <int WORDS>
+size_t ConcurrentInternTable<WORDS>::ReservedBytes() const
+{
+    size_t claimed = (next.load(std::memory_order_relaxed) + CHUNK_MASK) >> CHUNK_BITS;
+    return claimed * ((size_t)(CHUNK_MASK + 1) * WORDS * 4) + (mask + 1) * 8 + numChunks * sizeof(void*);
+}
+
+template <int WORDS>
+uint32_t* ConcurrentInternTable<WORDS>::Reserve(uint32_t id)
+{
+    size_t c = id >> CHUNK_BITS;
+    if (c >= numChunks) {
+        std::cerr << "Error: intern table out of IDs" << std::endl;
+        abort();
+    }
+    uint32_t* chunk = chunks[c].load(std::memory_order_acquire);
+    if (!chunk) {
+        uint32_t* fresh = new uint32_t[(size_t)(CHUNK_MASK + 1) * WORDS];
+        if (chunks[c].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) chunk = fresh;
+        else delete[] fresh;
+    }
+    return chunk + (size_t)(id & CHUNK_MASK) * WORDS;
+}
+
+template <int WORDS>
+uint32_t ConcurrentInternTable<WORDS>::Intern(const uint32_t* words, IdRange& ids)
+{
+    uint32_t h = InternHash<WORDS>(words);
+    uint32_t reserved = ~0u;  // ID holding our copy of the block, once written
+    size_t s = h & mask;
+    for (size_t probes = 0; probes < MAX_PROBES; probes++, s = (s + 1) & mask) {
+        uint64_t entry = slots[s].load(std::memory_order_acquire);
+        if (entry == 0) {
+            if (reserved == ~0u) {
+                if (ids.next == ids.end) {
+                    ids.next = next.fetch_add(ID_BATCH, std::memory_order_relaxed);
+                    ids.end = ids.next + ID_BATCH;
+                }
+                reserved = ids.next;
+                memcpy(Reserve(reserved), words, WORDS * 4);
+            }
+            uint64_t mine = ((uint64_t)h << 32) | (reserved + 1);
+            // Release: the block's words are visible before its slot
+            if (slots[s].compare_exchange_strong(entry, mine, std::memory_order_acq_rel)) {
+                ids.next++;
+                used.fetch_add(1, std::memory_order_relaxed);
+                return reserved;
+            }
+            // Lost the slot: entry now holds the winner, check it below
+        }
+        uint32_t id = (uint32_t)entry - 1;
+        if ((uint32_t)(entry >> 32) == h && memcmp(Get(id), words, WORDS * 4) == 0) return id;
+    }
+    overflowed.store(true, std::memory_order_relaxed);
+    return FAILED;
+}
+
+// Groups, roots and register chunks are all 8 words wide
+static_assert(StateStore::GROUP_PAGES == 8 && StateStore::NUM_GROUPS == 8 && StateStore::REG_CHUNK == 8, "one table width");
+static_assert(StateStore::NUM_PAGES == sizeof(Workspace::resident) / sizeof(uint32_t), "workspace page count");
+template class InternTable<StateStore::PAGE_WORDS>;
+template class InternTable<8>;
+template class ConcurrentInternTable<StateStore::PAGE_WORDS>;
+template class ConcurrentInternTable<8>;
+
+//////////////////////////////////////////////////////////////////////
+// STATE STORE
+//////////////////////////////////////////////////////////////////////
+
+template <template <int> class Table>
+CompactState BasicStateStore<Table>::Intern(Workspace& ws)
+{
+    const CPU& cpu = ws.cpu;
+    CompactState s;
+    s.pc = (uint32_t)cpu.PC;
+    for (int c = 0; c < CompactState::REG_CHUNKS; c++) s.regs[c] = InternRegs(ws, c);
+    uint32_t groupIds[NUM_GROUPS];
+    for (int g = 0; g < NUM_GROUPS; g++) {
+        uint32_t pageIds[GROUP_PAGES];
+        for (int p = 0; p < GROUP_PAGES; p++) pageIds[p] = InternPage(ws, g * GROUP_PAGES + p);
+        groupIds[g] = groups.Intern(pageIds, ws.groupIds);
+    }
+    s.memory = roots.Intern(groupIds, ws.rootIds);
+    return s;
+}
+
+template <template <int> class Table>
+CompactState BasicStateStore<Table>::Successor(const CompactState& parent, Workspace& ws, const StepEffect& effect)
+{
+    const CPU& cpu = ws.cpu;
+    CompactState s = parent;
+    s.pc = (uint32_t)cpu.PC;
+    if (effect.reg > 0) s.regs[effect.reg / REG_CHUNK] = InternRegs(ws, effect.reg / REG_CHUNK);
+    if (effect.word >= 0) {
+        int page = effect.word / PAGE_WORDS;
+        int group = page / GROUP_PAGES;
+        uint32_t pageId = InternPage(ws, page);
+        ws.resident[page] = pageId;
+
+        uint32_t pageIds[GROUP_PAGES];
+        uint32_t groupIds[NUM_GROUPS];
+        memcpy(groupIds, roots.Get(parent.memory), sizeof(groupIds));
+        memcpy(pageIds, groups.Get(groupIds[group]), sizeof(pageIds));
+        pageIds[page % GROUP_PAGES] = pageId;
+        groupIds[group] = groups.Intern(pageIds, ws.groupIds);
+        s.memory = roots.Intern(groupIds, ws.rootIds);
+    }
+    return s;
+}
+
+template <template <int> class Table>
+void BasicStateStore<Table>::Load(const CompactState& s, Workspace& ws)
+{
+    CPU& cpu = ws.cpu;
+    cpu.PC = s.pc;
+    for (int c = 0; c < CompactState::REG_CHUNKS; c++) {
+        const uint32_t* regs = regChunks.Get(s.regs[c]);
+        for (int r = 0; r < REG_CHUNK; r++) cpu.registers[c * REG_CHUNK + r] = (int)regs[r];
+    }
+    const uint32_t* groupIds = roots.Get(s.memory);
+    for (int g = 0; g < NUM_GROUPS; g++) {
+        const uint32_t* pageIds = groups.Get(groupIds[g]);
+        for (int p = 0; p < GROUP_PAGES; p++) {
+            int page = g * GROUP_PAGES + p;
+            if (ws.resident[page] == pageIds[p]) continue;
+            memcpy(&cpu.dmemory[page * PAGE_WORDS], pages.Get(pageIds[p]), PAGE_WORDS * 4);
+            ws.resident[page] = pageIds[p];
+        }
+    }
+}
+
+template <template <int> class Table>
+void BasicStateStore<Table>::Report(std::ostream& out, size_t states) const
+{
+    size_t bytes = Bytes(), reserved = ReservedBytes();
+    out << "State Store: " << pages.Size() << " pages, " << groups.Size() << " page groups, "
+        << roots.Size() << " memory images, " << regChunks.Size() << " register chunks, "
+        << bytes / 1024 << " KB";
+    if (states) out << " (" << (bytes + states * sizeof(CompactState)) / states << " bytes/state incl. the state itself)";
+    if (reserved != bytes) out << ", " << reserved / 1024 << " KB reserved";
+    out << std::endl;
+}
+
+template class BasicStateStore<InternTable>;
+template class BasicStateStore<ConcurrentInternTable>;
@@ -0,0 +1,174 @@
+#pragma once
+#include "CPU.h"
+#include "Transition.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// HASH-CONSED STATE STORE
+//
+// A full CPU::StateSnapshot is ~16.5 KB, but states reached from one
+// another differ in a register and at most one memory word. The store
+// interns every piece of state once and names it by a 32-bit ID:
+//   * memory is cut into 64-word pages; a group names 8 page IDs and
+//     the memory root names the 8 group IDs,
+//   * the register file is cut into 4 chunks of 8 registers.
+// Identical content always gets the same ID, so two states are equal
+// exactly when their IDs are equal. A state is 24 bytes, and a step that
+// stores to memory adds one page, one group and one root at most.
+//
+// The store is parameterized by its table: InternTable for one thread,
+// ConcurrentInternTable for a store shared by the parallel search.
+//////////////////////////////////////////////////////////////////////
+
+// IDs a thread has claimed from a ConcurrentInternTable in one go, so
+// threads do not contend on the table's ID counter for every block
+struct IdRange {
+    uint32_t next = 0, end = 0;
+};
+
+// Interns fixed-size blocks of WORDS 32-bit words. IDs are dense from 0.
+template <int WORDS>
+class InternTable {
+public:
+    explicit InternTable(unsigned logSlots = 4) : slots((size_t)1 << logSlots, EMPTY) {}
+
+    uint32_t Intern(const uint32_t* words);
+    uint32_t Intern(const uint32_t* words, IdRange&) { return Intern(words); }
+    const uint32_t* Get(uint32_t id) const { return &data[(size_t)id * WORDS]; }
+    size_t Size() const { return hashes.size(); }
+    size_t Bytes() const { return data.capacity() * 4 + hashes.capacity() * 4 + slots.capacity() * 4; }
+    size_t ReservedBytes() const { return Bytes(); }
+    bool Full() const { return false; }
+    bool Overflowed() const { return false; }
+
+private:
+    static constexpr uint32_t EMPTY = ~0u;
+    std::vector<uint32_t> data;    // block id lives at [id * WORDS, (id + 1) * WORDS)
+    std::vector<uint32_t> hashes;  // per block, so growing never rehashes content
+    std::vector<uint32_t> slots;   // open addressing over ids, power of two size
+
+    void Grow();
+};
+
+// Lock-free InternTable for many threads. Blocks are appended to fixed
+// chunks that never move, so Get needs no lock, and an ID is published by
+// a CAS into the index. The index cannot grow: Full() turns true at 3/4
+// load and the search must stop then. Two threads interning the same
+// block get the same ID; the loser's claimed ID is left unused. IDs are
+// claimed ID_BATCH at a time into the caller's IdRange. A probe gives up
+// after MAX_PROBES slots, so a table that does fill up between the
+// search's Full() checks fails (Intern returns FAILED and Overflowed()
+// turns true) instead of spinning forever.
+template <int WORDS>
+class ConcurrentInternTable {
+public:
+    explicit ConcurrentInternTable(unsigned logSlots = 22);
+    ~ConcurrentInternTable();
+    ConcurrentInternTable(const ConcurrentInternTable&) = delete;
+    ConcurrentInternTable& operator=(const ConcurrentInternTable&) = delete;
+
+    static const uint32_t ID_BATCH = 64;
+    static const size_t MAX_PROBES = 4096;
+    static const uint32_t FAILED = ~0u;
+
+    uint32_t Intern(const uint32_t* words, IdRange& ids);
+    const uint32_t* Get(uint32_t id) const {
+        return chunks[id >> CHUNK_BITS].load(std::memory_order_acquire) + (size_t)(id & CHUNK_MASK) * WORDS;
+    }
+    size_t Size() const { return used.load(std::memory_order_relaxed); }  // blocks interned
+    // The blocks and index slots in use, and what the table has set aside
+    // (the whole index, and every chunk of IDs claimed)
+    size_t Bytes() const { return Size() * (WORDS * 4 + 8); }
+    size_t ReservedBytes() const;
+    bool Full() const { return Size() * 4 > (mask + 1) * 3; }
+    bool Overflowed() const { return overflowed.load(std::memory_order_relaxed); }
+
+private:
+    static const int CHUNK_BITS = 12;
+    static const uint32_t CHUNK_MASK = (1u << CHUNK_BITS) - 1;
+    std::atomic<uint64_t>* slots;        // (hash << 32) | (id + 1), 0 = empty
+    size_t mask;
+    std::atomic<uint32_t*>* chunks;      // allocated on first use
+    size_t numChunks;
+    std::atomic<uint32_t> next{0};       // IDs claimed, used or not
+    std::atomic<size_t> used{0};
+    std::atomic<bool> overflowed{false};
+
+    uint32_t* Reserve(uint32_t id);
+};
+
+struct CompactState {
+    static const int REG_CHUNKS = 4;
+    uint32_t pc;
+    uint32_t regs[REG_CHUNKS];  // IDs of 8-register chunks
+    uint32_t memory;            // ID of the memory root
+
+    bool operator==(const CompactState& other) const {
+        if (pc != other.pc || memory != other.memory) return false;
+        for (int i = 0; i < REG_CHUNKS; i++) if (regs[i] != other.regs[i]) return false;
+        return true;
+    }
+};
+
+// A frontier entry: the state and its fingerprint, which its successors' fingerprints are updated from
+struct QueuedState {
+    CompactState state;
+    Fingerprint print;
+};
+
+// A CPU that stores load states into, and the page ID each of its pages
+// currently holds, so a load copies only the pages that differ. One per
+// thread, which also holds the thread's claimed IDs for each table.
+struct Workspace {
+    CPU cpu;
+    uint32_t resident[64];
+    IdRange pageIds, groupIds, rootIds, regIds;
+    Workspace() { for (uint32_t& p : resident) p = ~0u; }
+};
+
+template <template <int> class Table>
+class BasicStateStore {
+public:
+    static const int PAGE_WORDS = 64;
+    static const int NUM_PAGES = 4096 / PAGE_WORDS;
+    static const int GROUP_PAGES = 8;
+    static const int NUM_GROUPS = NUM_PAGES / GROUP_PAGES;
+    static const int REG_CHUNK = 8;
+
+    // logSlots sizes the tables' indexes: the initial size for InternTable, the fixed one for ConcurrentInternTable
+    explicit BasicStateStore(unsigned logSlots = 4)
+        : pages(logSlots), groups(logSlots), roots(logSlots), regChunks(logSlots) {}
+
+    // Interns the whole state of the workspace's CPU
+    CompactState Intern(Workspace& ws);
+    // Interns the state `ws` reached from `parent` in one step, touching only what `effect` says changed
+    CompactState Successor(const CompactState& parent, Workspace& ws, const StepEffect& effect);
+    // Writes s into the workspace's CPU. Pages it already holds are not copied again.
+    void Load(const CompactState& s, Workspace& ws);
+
+    size_t Bytes() const { return pages.Bytes() + groups.Bytes() + roots.Bytes() + regChunks.Bytes(); }
+    size_t ReservedBytes() const {
+        return pages.ReservedBytes() + groups.ReservedBytes() + roots.ReservedBytes() + regChunks.ReservedBytes();
+    }
+    bool Full() const { return pages.Full() || groups.Full() || roots.Full() || regChunks.Full(); }
+    // Some intern gave up on a full index; states built since are invalid
+    bool Overflowed() const {
+        return pages.Overflowed() || groups.Overflowed() || roots.Overflowed() || regChunks.Overflowed();
+    }
+    void Report(std::ostream& out, size_t states) const;
+
+private:
+    Table<PAGE_WORDS> pages;
+    Table<GROUP_PAGES> groups;
+    Table<NUM_GROUPS> roots;
+    Table<REG_CHUNK> regChunks;
+
+    uint32_t InternPage(Workspace& ws, int page) { return pages.Intern((const uint32_t*)&ws.cpu.dmemory[page * PAGE_WORDS], ws.pageIds); }
+    uint32_t InternRegs(Workspace& ws, int chunk) { return regChunks.Intern((const uint32_t*)&ws.cpu.registers[chunk * REG_CHUNK], ws.regIds); }
+};
+
+using StateStore = BasicStateStore<InternTable>;
+using SharedStateStore = BasicStateStore<ConcurrentInternTable>;  // safe to use from many threads
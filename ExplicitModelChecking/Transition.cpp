@@ -0,0 +1,216 @@
+#include "Transition.h"
+#include <algorithm>
+#include <cstring>
+
+std::vector<int> inputChoices;
+
+// --- PROPERTY CHECKER ---
+static bool VerifyState(CPU& cpu, Instruction& instr, Controller& ctrl, int32_t alu_res, StepEffect& effect) {
+    effect.address = alu_res;
+    // 1. SAFETY: Memory Bounds & Alignment
+    if (ctrl.MemRe || ctrl.MemWr) {
+        bool inputRead = ctrl.MemRe && alu_res == MMIO_INPUT_ADDR && !inputChoices.empty();
+        if (!inputRead && (alu_res < 0 || alu_res >= 4096 * 4)) {
+            effect.violation = VIOLATION_BOUNDS;
+            return false;
+        }
+        bool isWord = ((instr.instr.to_ulong() & 0x7000) == 0x2000);
+        if (isWord && (alu_res % 4 != 0)) {
+            effect.violation = VIOLATION_MISALIGNED;
+            return false;
+        }
+    }
+    // 2. INVARIANT: x0 is always 0
+    if (cpu.registers[0] != 0) {
+        effect.violation = VIOLATION_X0;
+        return false;
+    }
+    return true;
+}
+
+void ReportViolation(const StepEffect& effect, std::ostream& out) {
+    switch (effect.violation) {
+    case VIOLATION_BOUNDS:
+        out << "[FAIL] Memory Access Out of Bounds. PC: " << effect.oldPC << " Addr: " << effect.address << std::endl;
+        break;
+    case VIOLATION_MISALIGNED:
+        out << "[FAIL] Misaligned Word Access. PC: " << effect.oldPC << " Addr: " << effect.address << std::endl;
+        break;
+    case VIOLATION_X0:
+        out << "[FAIL] Register x0 corruption. PC: " << effect.oldPC << std::endl;
+        break;
+    default:
+        break;
+    }
+}
+
+Fingerprint FingerprintOf(const CPU& cpu) {
+    Fingerprint print = FingerprintMix::Mix(FingerprintMix::PC_LOCATION, (uint32_t)cpu.PC);
+    print ^= FingerprintMix::MixWords(FingerprintMix::REG_LOCATION, cpu.registers, 32);
+    print ^= FingerprintMix::MixWords(FingerprintMix::MEMORY_LOCATION, cpu.dmemory, 4096);
+    return print;
+}
+
+// --- TRANSITION ---
+bool Step(CPU& cpu, unsigned char* instMem, StepEffect& effect, Fingerprint& print) {
+    unsigned long pc = cpu.readPC();
+    effect.oldPC = pc;
+    Instruction myInst(instMem, pc);
+    unsigned long nextPC = pc + 4;
+
+    Controller myController(myInst);
+    ALU_Controller myALU_Control(myInst, myController.ALUOp);
+    int32_t ImmValue = ImmGen(myInst);
+
+    int rs1 = (myInst.instr.to_ulong() >> 15) & 0x1F;
+    int rs2 = (myInst.instr.to_ulong() >> 20) & 0x1F;
+    int rd = (myInst.instr.to_ulong() >> 7) & 0x1F;
+    cpu.registers[0] = 0;
+    int rs1Val = cpu.registers[rs1];
+    int rs2Val = cpu.registers[rs2];
+    int rs2Val_mux = myController.AluSrc ? ImmValue : rs2Val;
+    int32_t ALU_Res = ALU_Result(rs1Val, rs2Val_mux, myALU_Control.ALUOp);
+
+    // Safety Property Verification
+    if (!VerifyState(cpu, myInst, myController, ALU_Res, effect)) return false;
+
+    bool zeroFlag = (ALU_Res == 0);
+    if (myController.Branch && zeroFlag) nextPC = pc + ImmValue;
+    bool isWord = ((myInst.instr.to_ulong() & 0x7000) == 0x2000);
+    int32_t Read_Data;
+    if (myController.MemRe && ALU_Res == MMIO_INPUT_ADDR) {
+        effect.choices = (int)inputChoices.size();
+        Read_Data = isWord ? inputChoices[effect.choice] : (inputChoices[effect.choice] & 0xFF);
+    } else {
+        if (myController.MemWr) {
+            effect.word = ALU_Res / 4;
+            effect.oldWord = cpu.dmemory[effect.word];
+        }
+        Read_Data = cpu.DataMemory(myController.MemWr, myController.MemRe, ALU_Res, rs2Val, isWord);
+        if (myController.MemWr) {
+            FingerprintMix::Swap(print, FingerprintMix::MEMORY_LOCATION + effect.word, effect.oldWord, cpu.dmemory[effect.word]);
+        }
+    }
+    if (myController.regWrite && rd != 0) {
+        effect.reg = rd;
+        effect.oldReg = cpu.registers[rd];
+        if (myController.opcode == 0x6F) cpu.registers[rd] = pc + 4;
+        else cpu.registers[rd] = myController.MemtoReg ? Read_Data : ALU_Res;
+        FingerprintMix::Swap(print, FingerprintMix::REG_LOCATION + rd, effect.oldReg, cpu.registers[rd]);
+    }
+
+    cpu.incPC(nextPC);
+    FingerprintMix::Swap(print, FingerprintMix::PC_LOCATION, (uint32_t)pc, (uint32_t)nextPC);
+    return true;
+}
+
+void Undo(CPU& cpu, const StepEffect& effect, Fingerprint& print) {
+    if (effect.word >= 0) {
+        FingerprintMix::Swap(print, FingerprintMix::MEMORY_LOCATION + effect.word, cpu.dmemory[effect.word], effect.oldWord);
+        cpu.dmemory[effect.word] = effect.oldWord;
+    }
+    if (effect.reg > 0) {
+        FingerprintMix::Swap(print, FingerprintMix::REG_LOCATION + effect.reg, cpu.registers[effect.reg], effect.oldReg);
+        cpu.registers[effect.reg] = effect.oldReg;
+    }
+    FingerprintMix::Swap(print, FingerprintMix::PC_LOCATION, (uint32_t)cpu.PC, (uint32_t)effect.oldPC);
+    cpu.PC = effect.oldPC;
+}
+
+// --- STATE ENCODING ---
+// A count of DENSE means all 4096 words follow, without indices: smaller
+// than the sparse form once more than DENSE_WORDS words are nonzero
+static const uint32_t DENSE = ~0u;
+static const size_t DENSE_WORDS = 4096 * 4 / 6;
+
+// Writes the PC and registers, and returns where the word count goes
+static char* PutHeader(const CPU& cpu, char* p) {
+    uint32_t pc = (uint32_t)cpu.PC;
+    memcpy(p, &pc, 4);
+    memcpy(p + 4, cpu.registers, sizeof(cpu.registers));
+    return p + 4 + sizeof(cpu.registers);
+}
+
+static char* PutDense(const CPU& cpu, char* countAt) {
+    memcpy(countAt, &DENSE, 4);
+    memcpy(countAt + 4, cpu.dmemory, sizeof(cpu.dmemory));
+    return countAt + 4 + sizeof(cpu.dmemory);
+}
+
+void EncodeState(const CPU& cpu, std::vector<char>& out) {
+    // Written to a worst-case buffer first, so each word is a plain store
+    // rather than a vector insert
+    char buffer[8 + sizeof(cpu.registers) + 4096 * 6];
+    char* countAt = PutHeader(cpu, buffer);
+    char* p = countAt + 4;
+    uint32_t count = 0;
+    for (uint16_t block = 0; block < 4096; block += 16) {
+        // Most memory is zero: skip it 16 words at a time
+        int32_t any = 0;
+        for (int k = 0; k < 16; k++) any |= cpu.dmemory[block + k];
+        if (any == 0) continue;
+        for (uint16_t i = block; i < block + 16; i++) {
+            if (cpu.dmemory[i] == 0) continue;
+            memcpy(p, &i, 2);
+            memcpy(p + 2, &cpu.dmemory[i], 4);
+            p += 6;
+            count++;
+        }
+    }
+    if (count > DENSE_WORDS) p = PutDense(cpu, countAt);
+    else memcpy(countAt, &count, 4);
+    out.insert(out.end(), buffer, p);
+}
+
+char* EncodeState(const CPU& cpu, const std::vector<uint16_t>& live, int word, char* out) {
+    char* countAt = PutHeader(cpu, out);
+    if (live.size() + 1 > DENSE_WORDS) return PutDense(cpu, countAt);
+    char* p = countAt + 4;
+    uint32_t count = 0;
+    auto put = [&](uint16_t i) {
+        if (cpu.dmemory[i] == 0) return;
+        memcpy(p, &i, 2);
+        memcpy(p + 2, &cpu.dmemory[i], 4);
+        p += 6;
+        count++;
+    };
+    for (uint16_t i : live) {
+        if (word >= 0 && word <= i) {
+            if (word < i) put((uint16_t)word);
+            word = -1;
+        }
+        put(i);
+    }
+    if (word >= 0) put((uint16_t)word);
+    memcpy(countAt, &count, 4);
+    return p;
+}
+
+void EncodeState(const CPU& cpu, const std::vector<uint16_t>& live, int word, std::vector<char>& out) {
+    size_t at = out.size();
+    out.resize(at + 8 + sizeof(cpu.registers) + std::min((live.size() + 1) * 6, sizeof(cpu.dmemory)));
+    out.resize(EncodeState(cpu, live, word, &out[at]) - out.data());
+}
+
+const char* DecodeState(const char* in, CPU& cpu, std::vector<uint16_t>& live) {
+    for (uint16_t i : live) cpu.dmemory[i] = 0;
+    live.clear();
+    uint32_t pc, count;
+    memcpy(&pc, in, 4);
+    memcpy(cpu.registers, in + 4, sizeof(cpu.registers));
+    memcpy(&count, in + 4 + sizeof(cpu.registers), 4);
+    in += 8 + sizeof(cpu.registers);
+    cpu.PC = pc;
+    if (count == DENSE) {
+        memcpy(cpu.dmemory, in, sizeof(cpu.dmemory));
+        for (uint16_t i = 0; i < 4096; i++) live.push_back(i);
+        return in + sizeof(cpu.dmemory);
+    }
+    for (uint32_t k = 0; k < count; k++, in += 6) {
+        uint16_t i;
+        memcpy(&i, in, 2);
+        memcpy(&cpu.dmemory[i], in + 2, 4);
+        live.push_back(i);
+    }
+    return in;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "CPU.h"
+#include "Fingerprint.h"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// TRANSITION RELATION
+//
+// One step of the single-cycle datapath, shared by every search. A load
+// from MMIO_INPUT_ADDR reads the input port. Which values it may return is
+// set by inputChoices, and the step has one successor per value. When
+// inputChoices is empty, every state has exactly one successor and any
+// access to the port is out of bounds.
+//////////////////////////////////////////////////////////////////////
+
+static const int32_t MMIO_INPUT_ADDR = 0x4000;
+
+// Values a read of the input port may return
+extern std::vector<int> inputChoices;
+
+enum Violation { VIOLATION_NONE, VIOLATION_BOUNDS, VIOLATION_MISALIGNED, VIOLATION_X0 };
+
+// What one instruction changed, filled in by Step.
+// The old values make it an undo record as well.
+struct StepEffect {
+    unsigned long oldPC = 0;
+    int reg = -1;     // register written (never x0), -1 if none
+    int oldReg = 0;
+    int word = -1;    // data memory word written, -1 if none
+    int oldWord = 0;
+
+    int choice = 0;   // in: which input value an input read returns
+    int choices = 1;  // out: number of successors (input values) the instruction has
+
+    Violation violation = VIOLATION_NONE;  // out: set when Step returns false
+    int32_t address = 0;                   // out: the offending access
+};
+
+// Executes the instruction at the CPU's PC in place and records what it
+// changed. print is updated for the PC, register and memory word written.
+// Returns false, leaving the state as it was, if the instruction violates
+// a safety property.
+bool Step(CPU& cpu, unsigned char* instMem, StepEffect& effect, Fingerprint& print);
+
+// Takes back a successful Step: restores the PC, register and memory word
+// it wrote, and the fingerprint
+void Undo(CPU& cpu, const StepEffect& effect, Fingerprint& print);
+
+// Prints the "[FAIL] ..." line for a step that returned false
+void ReportViolation(const StepEffect& effect, std::ostream& out);
+
+// Full fingerprint of the CPU's state (the searches only need it for the initial state)
+Fingerprint FingerprintOf(const CPU& cpu);
+
+// Sparse encoding of a state, for searches that keep whole states outside
+// the state store: PC (4), registers (32 x 4), nonzero word count (4), then
+// (index: 2, value: 4) per nonzero memory word. A mostly nonzero memory is
+// written whole instead, with a count of ~0. Appends to out.
+void EncodeState(const CPU& cpu, std::vector<char>& out);
+
+// Longest encoding: the whole-memory form
+static const size_t MAX_ENCODED_STATE = 8 + 32 * 4 + 4096 * 4;
+
+// The same encoding, for a state whose nonzero memory words are among
+// live (ascending, as DecodeState leaves it) and word (-1 for none).
+// Only those words are looked at, instead of all of memory
+void EncodeState(const CPU& cpu, const std::vector<uint16_t>& live, int word, std::vector<char>& out);
+// ...written to out, which has room for MAX_ENCODED_STATE bytes. Returns the end
+char* EncodeState(const CPU& cpu, const std::vector<uint16_t>& live, int word, char* out);
+
+// Loads an encoded state into cpu and returns the end of the encoding.
+// live lists the words the previous DecodeState set; they are cleared first
+const char* DecodeState(const char* in, CPU& cpu, std::vector<uint16_t>& live);
@@ -0,0 +1,160 @@
+#include "VisitedTable.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+bool VisitedTable::Insert(const Fingerprint& print, const CompactState& state)
+{
+    size_t mask = entries.size() - 1;
+    for (size_t i = print.lo & mask; ; i = (i + 1) & mask) {
+        Entry& e = entries[i];
+        if (!e.used) {
+            e.print = print;
+            e.state = state;
+            e.used = true;
+            if (++count * 4 > entries.size() * 3) Grow();
+            return true;
+        }
+        if (e.print != print) continue;
+        fullCompares++;
+        if (e.state == state) return false;
+        collisions++;
+    }
+}
+
+void VisitedTable::Grow()
+{
+    std::vector<Entry> old(entries.size() * 2);
+    old.swap(entries);
+    size_t mask = entries.size() - 1;
+    for (const Entry& e : old) {
+        if (!e.used) continue;
+        size_t i = e.print.lo & mask;
+        while (entries[i].used) i = (i + 1) & mask;
+        entries[i] = e;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// CONCURRENT VISITED TABLE
+//////////////////////////////////////////////////////////////////////
+
+ConcurrentVisitedTable::ConcurrentVisitedTable(unsigned logSlots)
+{
+    // calloc'd, so untouched parts of the table cost no memory
+    mask = ((size_t)1 << logSlots) - 1;
+    entries = static_cast<Entry*>(calloc(mask + 1, sizeof(Entry)));
+    if (!entries) {
+        std::cerr << "Error: cannot allocate a 2^" << logSlots << " slot visited table" << std::endl;
+        exit(1);
+    }
+}
+
+ConcurrentVisitedTable::~ConcurrentVisitedTable()
+{
+    free(entries);
+}
+
+bool ConcurrentVisitedTable::Insert(const Fingerprint& print, const CompactState& state, Counters& counters)
+{
+    uint64_t key = print.lo ? print.lo : 1;  // 0 marks an empty slot
+    size_t i = key & mask;
+    for (size_t probes = 0; probes < MAX_PROBES; probes++, i = (i + 1) & mask) {
+        Entry& e = entries[i];
+        uint64_t lo = e.lo.load(std::memory_order_acquire);
+        if (lo == 0) {
+            if (e.lo.compare_exchange_strong(lo, key, std::memory_order_acq_rel)) {
+                e.hi = print.hi;
+                e.state = state;
+                e.ready.store(1, std::memory_order_release);
+                counters.inserted++;
+                return true;
+            }
+            // Lost the slot: lo now holds the winner's key
+        }
+        if (lo != key) continue;
+        while (!e.ready.load(std::memory_order_acquire)) {
+            std::this_thread::yield(); // the winner is between its CAS and its publish
+        }
+        if (e.hi != print.hi) continue;
+        counters.fullCompares++;
+        if (e.state == state) return false;
+        counters.collisions++;
+    }
+    overflowed.store(true, std::memory_order_relaxed);
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// HASH-COMPACTION TABLE
+//////////////////////////////////////////////////////////////////////
+
+bool CompactedTable::Insert(const Fingerprint& print)
+{
+    uint64_t key = print.lo ? print.lo : 1;  // 0 marks an empty slot
+    size_t mask = keys.size() - 1;
+    for (size_t i = key & mask; ; i = (i + 1) & mask) {
+        if (keys[i] == key) return false;
+        if (keys[i] != 0) continue;
+        keys[i] = key;
+        if (++count * 4 > keys.size() * 3) Grow();
+        return true;
+    }
+}
+
+void CompactedTable::Grow()
+{
+    std::vector<uint64_t> old(keys.size() * 2, 0);
+    old.swap(keys);
+    size_t mask = keys.size() - 1;
+    for (uint64_t key : old) {
+        if (key == 0) continue;
+        size_t i = key & mask;
+        while (keys[i] != 0) i = (i + 1) & mask;
+        keys[i] = key;
+    }
+}
+
+double CompactedTable::OmissionProbability() const
+{
+    // n (n - 1) / 2 pairs, each sharing a key with probability 2^-64
+    double pairs = (double)count * (double)(count - (count > 0)) / 2;
+    return -std::expm1(-pairs / 18446744073709551616.0);
+}
+
+//////////////////////////////////////////////////////////////////////
+// BITSTATE TABLE
+//////////////////////////////////////////////////////////////////////
+
+BitstateTable::BitstateTable(size_t bytes, int hashes) : hashes(hashes)
+{
+    size_t n = 1;
+    while (n * 2 <= bytes / 8) n *= 2;
+    words.assign(n, 0);
+    mask = (uint64_t)n * 64 - 1;
+}
+
+bool BitstateTable::Insert(const Fingerprint& print)
+{
+    // k indexes lo + i * hi: independent enough when hi is odd
+    uint64_t step = print.hi | 1;
+    // Chance that other states had already set all k bits, hiding this one
+    double fill = Fill(), probability = 1;
+    for (int i = 0; i < hashes; i++) probability *= fill;
+    bool fresh = false;
+    for (int i = 0; i < hashes; i++) {
+        uint64_t bit = (print.lo + i * step) & mask;
+        uint64_t& word = words[bit >> 6];
+        uint64_t m = 1ULL << (bit & 63);
+        if (!(word & m)) {
+            word |= m;
+            bitsSet++;
+            fresh = true;
+        }
+    }
+    if (!fresh) return false;
+    omitted += probability;
+    count++;
+    return true;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "StateStore.h"
+#include "Fingerprint.h"
+#include <atomic>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// EXACT VISITED SET
+//
+// Open addressing keyed by the 128-bit state fingerprint. A probe looks
+// at fingerprints only, and compares the stored CompactState (six IDs)
+// only when the fingerprints match. That compare is what keeps the set
+// exact: two different states that collide on all 128 bits are still
+// told apart, and counted.
+//////////////////////////////////////////////////////////////////////
+
+class VisitedTable {
+public:
+    VisitedTable() : entries(1024) {}
+
+    // True if the state was not in the set yet
+    bool Insert(const Fingerprint& print, const CompactState& state);
+    size_t Size() const { return count; }
+    size_t Bytes() const { return entries.capacity() * sizeof(Entry); }
+
+    unsigned long long fullCompares = 0;  // fingerprint matched, states compared
+    unsigned long long collisions = 0;    // ...and they were different states
+
+private:
+    struct Entry {
+        Fingerprint print;
+        CompactState state;
+        bool used = false;
+    };
+    std::vector<Entry> entries; // power of two size, at most 3/4 full
+    size_t count = 0;
+
+    void Grow();
+};
+
+// Lock-free VisitedTable for the parallel search. An insert claims a slot
+// by CAS on the fingerprint's low word, then writes the rest of the entry
+// and publishes it with `ready`. A thread that finds a claimed slot with
+// the same low word waits for it to be published before comparing, so the
+// set stays exact. The table cannot grow; its capacity is fixed up front.
+// An insert gives up after MAX_PROBES slots and sets Overflowed(), so a
+// table that fills up fails instead of probing forever.
+class ConcurrentVisitedTable {
+public:
+    // Per-thread tallies, summed at the end of the search
+    struct Counters {
+        unsigned long long inserted = 0;
+        unsigned long long fullCompares = 0;
+        unsigned long long collisions = 0;
+    };
+
+    explicit ConcurrentVisitedTable(unsigned logSlots);
+    ~ConcurrentVisitedTable();
+    ConcurrentVisitedTable(const ConcurrentVisitedTable&) = delete;
+    ConcurrentVisitedTable& operator=(const ConcurrentVisitedTable&) = delete;
+
+    static const size_t MAX_PROBES = 4096;
+
+    // True if the state was not in the set yet. False as well when the
+    // table overflowed, which the caller must check for
+    bool Insert(const Fingerprint& print, const CompactState& state, Counters& counters);
+    bool Overflowed() const { return overflowed.load(std::memory_order_relaxed); }
+    size_t Capacity() const { return mask + 1; }
+    size_t Bytes() const { return Capacity() * sizeof(Entry); }
+    static size_t EntryBytes() { return sizeof(Entry); }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> lo;      // fingerprint low word, 0 = empty
+        std::atomic<uint32_t> ready;   // hi and state written
+        uint64_t hi;
+        CompactState state;
+    };
+    Entry* entries;
+    size_t mask;
+    std::atomic<bool> overflowed{false};
+};
+
+// Hash-compaction visited set: open addressing over the 64-bit low word
+// of each state's fingerprint, 8 bytes a slot, and nothing else. Two
+// states sharing a low word count as one, so the second is wrongly
+// skipped. Among n states that happens with probability about n^2 / 2^65.
+class CompactedTable {
+public:
+    CompactedTable() : keys(1024, 0) {}
+
+    // True if no state with the same key was in the set yet
+    bool Insert(const Fingerprint& print);
+    size_t Size() const { return count; }
+    size_t Bytes() const { return keys.capacity() * sizeof(uint64_t); }
+    // Probability that some two of the states inserted share a key
+    double OmissionProbability() const;
+
+private:
+    std::vector<uint64_t> keys;  // 0 = empty, power of two size, at most 3/4 full
+    size_t count = 0;
+
+    void Grow();
+};
+
+// Bitstate (supertrace) visited set: a fixed bit array, with each state
+// setting k bits picked by double hashing of its fingerprint. A state
+// counts as visited when all k bits are already set, so a new state is
+// wrongly skipped with probability about fill^k. The table sums that
+// probability over every state it admits. That is only the expected number
+// of direct collisions: each state skipped that way also hides every state
+// reachable only through it, so the real loss is larger, often by far.
+// Past a fill of 1/k the real loss is no longer small.
+class BitstateTable {
+public:
+    // bytes is rounded down to a power of two
+    BitstateTable(size_t bytes, int hashes);
+
+    // True if at least one of the state's bits was clear
+    bool Insert(const Fingerprint& print);
+    size_t Size() const { return count; }
+    size_t Bytes() const { return words.size() * 8; }
+    double Fill() const { return (double)bitsSet / ((double)words.size() * 64); }
+    // Expected number of new states taken for visited ones: a lower bound
+    // on the states omitted
+    double DirectCollisions() const { return omitted; }
+    // More than 1/k of the bits are set
+    bool Overfilled() const { return bitsSet * hashes > words.size() * 64; }
+
+private:
+    std::vector<uint64_t> words;
+    uint64_t mask;  // bit index mask
+    int hashes;
+    size_t count = 0;
+    size_t bitsSet = 0;
+    double omitted = 0;
+};
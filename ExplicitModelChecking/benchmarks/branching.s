@@ -0,0 +1,17 @@
+lui x10, 4
+ori x4, x0, 4
+ori x6, x0, 40
+ori x7, x0, 18
+loop:
+lw x5, 0, x10
+add x1, x1, x5
+sw x1, 0, x3
+add x3, x3, x4
+beq x3, x6, wrap
+jal x0, next
+wrap:
+xor x3, x3, x3
+next:
+beq x1, x7, done
+jal x0, loop
+done:
@@ -0,0 +1,16 @@
+ori x2, x0, 1
+ori x4, x0, 4
+lui x5, 4
+lui x6, 49
+loop:
+add x1, x1, x2
+sw x1, 0, x3
+add x3, x3, x4
+beq x3, x5, wrap
+jal x0, next
+wrap:
+xor x3, x3, x3
+next:
+beq x1, x6, done
+jal x0, loop
+done:
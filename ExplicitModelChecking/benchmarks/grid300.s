@@ -0,0 +1,14 @@
+lui x10, 4
+ori x7, x0, 300
+loop:
+lw x5, 0, x10
+add x1, x1, x5
+beq x1, x7, done
+lw x6, 0, x10
+add x2, x2, x6
+beq x2, x7, wrap
+jal x0, loop
+wrap:
+xor x2, x2, x2
+jal x0, loop
+done:
@@ -38,8 +38,9 @@ void CPU::RestoreState(const StateSnapshot& s) {
     for(int i=0; i<4096; i++) dmemory[i] = s.memory[i];
 }
 
-Instruction::Instruction(unsigned char instructionMem[], CPU cpu) {
-    unsigned long currentPC = cpu.readPC();
+Instruction::Instruction(unsigned char instructionMem[], CPU cpu) : Instruction(instructionMem, cpu.readPC()) {}
+
+Instruction::Instruction(unsigned char instructionMem[], unsigned long currentPC) {
     uint32_t combined = 0;
     for (int i = currentPC; i < currentPC + 4; ++i) {
         combined = (combined << 8) | instructionMem[i];
@@ -41,6 +41,7 @@ class Instruction {
 public:
     uint32_t instr; // Changed from bitset<32> to raw int
     Instruction(unsigned char instructionMem[], CPU cpu);
+    Instruction(unsigned char instructionMem[], unsigned long pc); // fetch without a CPU copy
 };
 
 class Controller {
@@ -0,0 +1,147 @@
+#ifndef COW_MEMORY_H
+#define COW_MEMORY_H
+
+#include "CPU.h"
+#include <memory>
+
+// Copy-on-write data memory for forking execution.
+// The 4096 words are split into 64-word pages. Pages are reference counted and
+// shared between forks, and so is the page table itself, so copying a
+// CowMemory is one pointer copy. A write copies the page table and the target
+// page only if another fork still shares them.
+class CowMemory {
+public:
+    static const int NUM_WORDS = 4096;
+    static const int PAGE_WORDS = 64;
+    static const int NUM_PAGES = NUM_WORDS / PAGE_WORDS;
+
+    struct Page {
+        int words[PAGE_WORDS];
+    };
+
+    CowMemory() : table(ZeroTable()) {}
+
+    int Read(int index) const {
+        return table->pages[index / PAGE_WORDS]->words[index % PAGE_WORDS];
+    }
+
+    void Write(int index, int value) {
+        if (Read(index) == value) return; // no change, keep sharing
+        if (table.use_count() > 1) table = std::make_shared<PageTable>(*table);
+        std::shared_ptr<Page>& page = table->pages[index / PAGE_WORDS];
+        if (page.use_count() > 1) page = std::make_shared<Page>(*page);
+        page->words[index % PAGE_WORDS] = value;
+    }
+
+    bool operator==(const CowMemory& other) const {
+        if (table == other.table) return true;
+        for (int p = 0; p < NUM_PAGES; p++) {
+            const Page* a = table->pages[p].get();
+            const Page* b = other.table->pages[p].get();
+            if (a == b) continue; // shared page, equal by construction
+            for (int i = 0; i < PAGE_WORDS; i++) if (a->words[i] != b->words[i]) return false;
+        }
+        return true;
+    }
+
+private:
+    struct PageTable {
+        std::shared_ptr<Page> pages[NUM_PAGES];
+    };
+    std::shared_ptr<PageTable> table;
+
+    // Every fresh memory starts out pointing at one shared all-zero table
+    static std::shared_ptr<PageTable> ZeroTable() {
+        static std::shared_ptr<PageTable> zero = [] {
+            std::shared_ptr<Page> page = std::make_shared<Page>();
+            for (int i = 0; i < PAGE_WORDS; i++) page->words[i] = 0;
+            std::shared_ptr<PageTable> t = std::make_shared<PageTable>();
+            for (int p = 0; p < NUM_PAGES; p++) t->pages[p] = page;
+            return t;
+        }();
+        return zero;
+    }
+};
+
+// Forkable CPU state: forks copy the PC and registers and share memory pages.
+// `hash` is a Zobrist hash of the whole state: the XOR of one mix per
+// location (PC, registers, memory words). Writing through SetPC, SetReg and
+// DataMemory XORs the old mix out and the new one in, so a successor's hash
+// costs O(1) instead of a pass over 16 KB.
+struct CowState {
+    unsigned long pc = 0;
+    int regs[32] = {0};
+    CowMemory memory;
+    uint64_t hash = 0; // all-zero state: every mix is zero
+
+    static const uint32_t PC_LOCATION = 0;
+    static const uint32_t REG_LOCATION = 1;
+    static const uint32_t MEMORY_LOCATION = 33;
+
+    // Odd per-location key, a splitmix64 hash of the location. Keys that are
+    // multiples of one constant would make value * key repeat across
+    // locations, e.g. Mix(0, 3) and Mix(2, 1).
+    static uint64_t Key(uint32_t location) {
+        uint64_t k = (location + 0x51ED270B27D4EB4FULL) * 0x9E3779B97F4A7C15ULL;
+        k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+        return (k ^ (k >> 31)) | 1;
+    }
+
+    // Zero values mix to zero, so untouched memory costs nothing
+    static uint64_t Mix(uint32_t location, uint32_t value) {
+        uint64_t h = (uint64_t)value * Key(location);
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        return h ^ (h >> 29);
+    }
+
+    void SetPC(unsigned long value) {
+        hash ^= Mix(PC_LOCATION, (uint32_t)pc) ^ Mix(PC_LOCATION, (uint32_t)value);
+        pc = value;
+    }
+
+    void SetReg(int r, int value) {
+        hash ^= Mix(REG_LOCATION + r, (uint32_t)regs[r]) ^ Mix(REG_LOCATION + r, (uint32_t)value);
+        regs[r] = value;
+    }
+
+    // Recomputes hash from scratch (after filling the fields directly)
+    void Rehash() {
+        hash = Mix(PC_LOCATION, (uint32_t)pc);
+        for (int i = 0; i < 32; i++) hash ^= Mix(REG_LOCATION + i, (uint32_t)regs[i]);
+        for (int i = 0; i < CowMemory::NUM_WORDS; i++) hash ^= Mix(MEMORY_LOCATION + i, (uint32_t)memory.Read(i));
+    }
+
+    bool operator==(const CowState& other) const {
+        if (hash != other.hash) return false; // different hashes always mean different states
+        if (pc != other.pc) return false;
+        for (int i = 0; i < 32; i++) if (regs[i] != other.regs[i]) return false;
+        return memory == other.memory;
+    }
+
+    // Same semantics as CPU::DataMemory
+    int32_t DataMemory(int MemWrite, int MemRead, int ALUResult, int rs2, bool word) {
+        int index = ALUResult / 4;
+        if (index < 0 || index >= CowMemory::NUM_WORDS) return 0;
+
+        if (MemWrite) {
+            int old = memory.Read(index);
+            int value = word ? rs2 : ((old & 0xFFFFFF00) | (rs2 & 0xFF));
+            hash ^= Mix(MEMORY_LOCATION + index, (uint32_t)old) ^ Mix(MEMORY_LOCATION + index, (uint32_t)value);
+            memory.Write(index, value);
+            return 0;
+        } else if (MemRead) {
+            if (word) return memory.Read(index);
+            else return memory.Read(index) & 0xFF;
+        }
+        return 0;
+    }
+};
+
+// For hashed containers of CowStates: the maintained hash, no pass over the state
+struct CowStateHash {
+    size_t operator()(const CowState& s) const { return (size_t)s.hash; }
+};
+
+#endif
@@ -1,114 +1,127 @@
 #include "CPU.h"
+#include "TransitionSystem.h"
 #include <iostream>
 #include <vector>
 #include <queue>
-#include <unordered_set>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
-// Custom Hash
-struct StateHash {
-    size_t operator()(const CPU::StateSnapshot& s) const {
-        size_t h1 = std::hash<unsigned long>{}(s.pc);
-        size_t h2 = 0;
-        for (int i = 0; i < 32; i++) h2 ^= std::hash<int>{}(s.regs[i]) + 0x9e3779b9 + (h2 << 6) + (h2 >> 2);
-        for (int i = 0; i < 100; i++) h2 ^= std::hash<int>{}(s.memory[i]) + 0x9e3779b9 + (h2 << 6) + (h2 >> 2);
-        return h1 ^ (h2 << 1);
-    }
+// How a discovered state was reached. On a failure the chain back to the
+// initial state is written as a cpusim replay log (CPU_Files/Replay.h), so
+// `cpusim --replay` can rerun the exact path with tracing attached.
+struct PathNode {
+    int parent;                // -1 for the initial state
+    unsigned long long depth;  // instructions retired to reach the state
+    bool input;                // the last step read MMIO_INPUT_ADDR
+    bool interrupt;            // the last step took an interrupt instead of an instruction
+    int value;                 // input value read
 };
 
-bool VerifyState(CPU& cpu, Instruction& instr, Controller& ctrl, int32_t alu_res) {
+static const char* replayOut = nullptr;
+
+// Writes the input reads and interrupts along the path to `last`
+void WriteReplayLog(const std::vector<PathNode>& nodes, int last) {
+    if (!replayOut) return;
+    std::vector<std::string> events;
+    int inputs = 0;
+    for (int n = last; n >= 0 && nodes[n].parent >= 0; n = nodes[n].parent) {
+        unsigned long long at = nodes[nodes[n].parent].depth;
+        if (nodes[n].input) events.push_back("I " + std::to_string(at) + " 0 " + std::to_string(nodes[n].value));
+        else if (nodes[n].interrupt) events.push_back("Q " + std::to_string(at) + " -1");
+        inputs += nodes[n].input;
+    }
+    std::reverse(events.begin(), events.end());
+    std::ofstream out(replayOut);
+    out << "# counterexample path from modelchecker, replay with: cpusim --replay <this file> <program>\n";
+    for (auto& e : events) out << e << "\n";
+    std::cerr << "[PATH] " << nodes[last].depth << " instructions, " << inputs << " input reads, "
+              << events.size() - inputs << " interrupts written to " << replayOut << std::endl;
+}
+
+bool VerifyState(unsigned long pc, Instruction& instr, Controller& ctrl, int32_t alu_res) {
     if (ctrl.MemRe || ctrl.MemWr) {
         if (alu_res < 0 || alu_res >= 4096 * 4) {
             if (alu_res != CPU::MMIO_INPUT_ADDR) {
-                std::cerr << "[FAIL] Memory Violation. PC: " << cpu.readPC() << " Addr: " << alu_res << std::endl;
+                std::cerr << "[FAIL] Memory Violation. PC: " << pc << " Addr: " << alu_res << std::endl;
                 return false;
             }
         }
         // Updated: Access raw instr directly
         bool isWord = ((instr.instr & 0x7000) == 0x2000); 
         if (isWord && (alu_res % 4 != 0)) {
-            std::cerr << "[FAIL] Misalignment. PC: " << cpu.readPC() << " Addr: " << alu_res << std::endl;
+            std::cerr << "[FAIL] Misalignment. PC: " << pc << " Addr: " << alu_res << std::endl;
             return false;
         }
     }
     return true;
 }
 
+// States are CowStates: a fork copies the PC and registers and shares
+// memory pages with its parent, and its hash is updated in O(1) by the
+// writes TransitionSystem makes, so the visited set never scans memory.
 void RunBFS(unsigned char* instMem, int maxPC) {
-    CPU myCPU;
-    std::queue<CPU::StateSnapshot> q;
-    std::unordered_set<CPU::StateSnapshot, StateHash> visited;
+    TransitionSystem system;
+    std::queue<std::pair<CowState, int>> q;
+    std::unordered_map<CowState, int, CowStateHash> visited;
+    std::vector<PathNode> nodes;
 
-    CPU::StateSnapshot initial = myCPU.GetState();
-    q.push(initial);
-    visited.insert(initial);
+    CowState initial;
+    nodes.push_back({-1, 0, false, false, 0});
+    q.push({initial, 0});
+    visited.emplace(initial, 0);
 
     int states_explored = 0;
-    
-    // Explicit Inputs for Forking
-    std::vector<int> test_inputs = {0, 1, 42, 100};
 
     while (!q.empty()) {
-        CPU::StateSnapshot current_snap = q.front();
+        CowState current = q.front().first;
+        int node = q.front().second;
         q.pop();
         states_explored++;
 
-        myCPU.RestoreState(current_snap);
-        unsigned long pc = myCPU.readPC();
-
-        if (pc >= maxPC * 4 || pc >= 4096) continue;
-
-        Instruction myInst(instMem, myCPU);
-        unsigned long nextPC = pc + 4;
+        unsigned long pc = current.pc;
+        if (pc >= (unsigned long)maxPC * 4 || pc >= 4096) continue;
 
+        // SAFETY CHECK of the instruction about to run
+        Instruction myInst(instMem, pc);
         Controller myCtrl(myInst);
         ALU_Controller myALU(myInst, myCtrl.ALUOp);
         int32_t ImmVal = ImmGen(myInst);
-
         int rs1 = (myInst.instr >> 15) & 0x1F;
         int rs2 = (myInst.instr >> 20) & 0x1F;
-        int rd = (myInst.instr >> 7) & 0x1F;
-
-        myCPU.registers[0] = 0;
-        int rs1Val = myCPU.registers[rs1];
-        int rs2Val = myCPU.registers[rs2];
-        int rs2Val_mux = myCtrl.AluSrc ? ImmVal : rs2Val;
-        
+        int rs1Val = rs1 ? current.regs[rs1] : 0;
+        int rs2Val_mux = myCtrl.AluSrc ? ImmVal : (rs2 ? current.regs[rs2] : 0);
         int32_t ALU_Res = ALU_Result(rs1Val, rs2Val_mux, myALU.ALUOp);
-
-        if (!VerifyState(myCPU, myInst, myCtrl, ALU_Res)) return;
-
-        // NON-DETERMINISM FORK
-        bool isInput = (myCtrl.MemRe && ALU_Res == CPU::MMIO_INPUT_ADDR);
-        std::vector<int> inputs_to_try;
-        
-        if (isInput) inputs_to_try = test_inputs;
-        else {
-            bool isWord = ((myInst.instr & 0x7000) == 0x2000);
-            inputs_to_try.push_back(myCPU.DataMemory(myCtrl.MemWr, myCtrl.MemRe, ALU_Res, rs2Val, isWord));
+        if (!VerifyState(pc, myInst, myCtrl, ALU_Res)) {
+            WriteReplayLog(nodes, node);
+            return;
         }
 
-        for (int val : inputs_to_try) {
-            CPU forkCPU = myCPU;
-            
-            if (myCtrl.regWrite && rd != 0) {
-                if (myCtrl.opcode == 0x6F) forkCPU.registers[rd] = pc + 4;
-                else forkCPU.registers[rd] = myCtrl.MemtoReg ? val : ALU_Res;
-            }
-
-            unsigned long forkNextPC = nextPC;
-            bool zero = (ALU_Res == 0);
-            if (myCtrl.Branch && zero) forkNextPC = pc + ImmVal;
-            
-            forkCPU.incPC(forkNextPC);
-
-            CPU::StateSnapshot next_state = forkCPU.GetState();
-            if (visited.find(next_state) == visited.end()) {
-                visited.insert(next_state);
-                q.push(next_state);
+        // NON-DETERMINISM FORK: one successor per input value, plus the interrupt
+        std::vector<CowState> next_states = system.GetNextStates(current, instMem, maxPC);
+        if (system.nonTerminating) {
+            std::cout << "[FAIL] Non-Termination: idle loop at PC " << pc
+                      << " with interrupts disabled, nothing can change the state" << std::endl;
+            WriteReplayLog(nodes, node);
+            return;
+        }
+        bool isInput = myCtrl.MemRe && ALU_Res == CPU::MMIO_INPUT_ADDR;
+        for (size_t i = 0; i < next_states.size(); i++) {
+            bool interrupt = system.interrupted && i + 1 == next_states.size();
+            bool input = isInput && !interrupt;
+            int val = input ? system.INTERESTING_INPUTS[i] : 0;
+            unsigned long long depth = nodes[node].depth + (interrupt ? 0 : 1);
+            nodes.push_back({node, depth, input, interrupt, val});
+            int next = (int)nodes.size() - 1;
+            if (visited.emplace(next_states[i], next).second) {
+                q.push({next_states[i], next});
             } else {
-                std::cout << "[FAIL] Loop Detected! Value: " << val << std::endl;
+                std::cout << "[FAIL] Loop Detected! PC: " << next_states[i].pc;
+                if (input) std::cout << " Value: " << val;
+                std::cout << std::endl;
+                WriteReplayLog(nodes, next);
                 return;
             }
         }
@@ -118,6 +131,7 @@ void RunBFS(unsigned char* instMem, int maxPC) {
 
 int main(int argc, char* argv[]) {
     if (argc < 2) return -1;
+    if (argc > 2) replayOut = argv[2]; // modelchecker program.txt [counterexample.log]
     unsigned char instMem[4096] = {0};
     std::ifstream infile(argv[1]);
     if (!infile.is_open()) return 0;
@@ -2,6 +2,7 @@
 #define TRANSITION_SYSTEM_H
 
 #include "CPU.h"
+#include "CowMemory.h"
 #include <vector>
 
 class TransitionSystem {
@@ -9,29 +10,39 @@ public:
     // Inputs to try when reading from MMIO_INPUT_ADDR (0x4000)
     const std::vector<int> INTERESTING_INPUTS = {0, 1, 42, 100, -1}; 
 
-    std::vector<CPU::StateSnapshot> GetNextStates(const CPU::StateSnapshot& current, unsigned char* instMem, int maxPC) {
-        std::vector<CPU::StateSnapshot> next_states;
-        
-        CPU myCPU;
-        myCPU.RestoreState(current);
+    // Set by GetNextStates when `current` is an idle self-loop (the instruction
+    // leaves the whole state unchanged) and no interrupt can ever arrive.
+    bool nonTerminating = false;
+
+    // Set by GetNextStates when the last successor is the interrupt fork.
+    // The ones before it are the input forks, in INTERESTING_INPUTS order,
+    // or the one ordinary step.
+    bool interrupted = false;
+
+    // Successor states share memory pages with `current` (copy-on-write), so
+    // each fork only copies the PC and register file. Every write goes through
+    // the CowState setters, so each successor's hash is updated in O(1).
+    std::vector<CowState> GetNextStates(const CowState& current, unsigned char* instMem, int maxPC) {
+        std::vector<CowState> next_states;
+        nonTerminating = false;
+        interrupted = false;
         
-        unsigned long pc = myCPU.readPC();
+        unsigned long pc = current.pc;
         // TERMINATION CHECK
-        if (pc >= maxPC * 4 || pc >= 4096) return next_states; 
+        if (pc >= (unsigned long)maxPC * 4 || pc >= 4096) return next_states;
 
         // 1. FETCH & DECODE
-        Instruction myInst(instMem, myCPU);
+        Instruction myInst(instMem, pc);
         Controller myCtrl(myInst);
         ALU_Controller myALU(myInst, myCtrl.ALUOp);
         int32_t ImmVal = ImmGen(myInst);
 
-        int rs1 = (myInst.instr.to_ulong() >> 15) & 0x1F;
-        int rs2 = (myInst.instr.to_ulong() >> 20) & 0x1F;
-        int rd = (myInst.instr.to_ulong() >> 7) & 0x1F;
+        int rs1 = (myInst.instr >> 15) & 0x1F;
+        int rs2 = (myInst.instr >> 20) & 0x1F;
+        int rd = (myInst.instr >> 7) & 0x1F;
 
-        myCPU.registers[0] = 0;
-        int rs1Val = myCPU.registers[rs1];
-        int rs2Val = myCPU.registers[rs2];
+        int rs1Val = rs1 ? current.regs[rs1] : 0;
+        int rs2Val = rs2 ? current.regs[rs2] : 0;
         int rs2Val_mux = myCtrl.AluSrc ? ImmVal : rs2Val;
         
         int32_t ALU_Res = ALU_Result(rs1Val, rs2Val_mux, myALU.ALUOp);
@@ -42,64 +53,79 @@ public:
         if (isInputRead) {
             // FORK 1: Create a state for each possible input
             for (int input_val : INTERESTING_INPUTS) {
-                CPU forkCPU = myCPU;
+                CowState fork = current;
+                fork.SetReg(0, 0);
                 if (myCtrl.regWrite && rd != 0) {
-                    forkCPU.registers[rd] = input_val; 
+                    fork.SetReg(rd, input_val);
                 }
-                forkCPU.incPC(pc + 4);
-                next_states.push_back(forkCPU.GetState());
+                fork.SetPC(pc + 4);
+                next_states.push_back(fork);
             }
         } 
         else {
             // NORMAL EXECUTION
-            CPU normalCPU = myCPU;
-            bool isWord = ((myInst.instr.to_ulong() & 0x7000) == 0x2000);
+            CowState normal = current;
+            normal.SetReg(0, 0);
+            bool isWord = ((myInst.instr & 0x7000) == 0x2000);
             int32_t memData = 0;
             
             // Execute Memory Access safely
             if (myCtrl.MemRe || myCtrl.MemWr) {
                 // Bounds check happens in VerifyState, here we just run logic
                 if (ALU_Res >= 0 && ALU_Res < 4096 * 4) {
-                    memData = normalCPU.DataMemory(myCtrl.MemWr, myCtrl.MemRe, ALU_Res, rs2Val, isWord);
+                    memData = normal.DataMemory(myCtrl.MemWr, myCtrl.MemRe, ALU_Res, rs2Val, isWord);
                 }
             }
 
             // Execute Writeback
             unsigned long nextPC = pc + 4;
             if (myCtrl.regWrite && rd != 0) {
-                if (myCtrl.opcode == 0x6F) normalCPU.registers[rd] = pc + 4;
-                else normalCPU.registers[rd] = myCtrl.MemtoReg ? memData : ALU_Res;
+                if (myCtrl.opcode == 0x6F) normal.SetReg(rd, pc + 4);
+                else normal.SetReg(rd, myCtrl.MemtoReg ? memData : ALU_Res);
             }
 
             // Execute Branch
             bool zero = (ALU_Res == 0);
             if (myCtrl.Branch && zero) nextPC = pc + ImmVal;
             
-            normalCPU.incPC(nextPC);
-            next_states.push_back(normalCPU.GetState());
+            normal.SetPC(nextPC);
+
+            // IDLE LOOP (e.g. beq x0,x0,0 / jal x0,0): spinning only repeats this
+            // state, so skip straight to the interrupt fork, or report that
+            // nothing can ever happen again if interrupts are off.
+            if (normal == current) {
+                if (!(current.regs[CPU::MSTATUS_REG] & 0x1)) {
+                    nonTerminating = true;
+                    next_states.push_back(normal);
+                }
+            } else {
+                next_states.push_back(normal);
+            }
         }
 
         // 3. INTERRUPT FORK (Non-Determinism Type 2)
         // Check if interrupts are enabled (Mock: bit 0 of MSTATUS_REG x12)
-        bool interruptsEnabled = (myCPU.registers[CPU::MSTATUS_REG] & 0x1);
+        bool interruptsEnabled = (current.regs[CPU::MSTATUS_REG] & 0x1);
 
         if (interruptsEnabled) {
-            CPU interruptCPU = myCPU;
+            CowState interrupt = current;
+            interrupt.SetReg(0, 0);
             
             // Save current PC to EPC (x30)
-            interruptCPU.registers[CPU::EPC_REG] = pc; 
+            interrupt.SetReg(CPU::EPC_REG, pc);
             
             // Disable Interrupts (Clear bit in MSTATUS x12)
-            interruptCPU.registers[CPU::MSTATUS_REG] &= ~0x1; 
+            interrupt.SetReg(CPU::MSTATUS_REG, interrupt.regs[CPU::MSTATUS_REG] & ~0x1);
             
             // Jump to Handler
-            interruptCPU.PC = CPU::ISR_HANDLER_ADDR; 
+            interrupt.SetPC(CPU::ISR_HANDLER_ADDR);
             
-            next_states.push_back(interruptCPU.GetState());
+            next_states.push_back(interrupt);
+            interrupted = true;
         }
 
         return next_states;
     }
 };
 
-#endif
\ No newline at end of file
+#endif